@@ -1,9 +1,33 @@
+#include <charconv>
 #include <iostream>
+#include <string>
+#include <system_error>
 
 int getInteger()
 {
-	std::cout << "Enter an integer: ";
-	int x{};
-	std::cin >> x;
-	return x;
-}
\ No newline at end of file
+	while (true)
+	{
+		std::cout << "Enter an integer: ";
+		std::string token{};
+		if (!(std::cin >> token))
+		{
+			std::cerr << "No more input, using 0.\n";
+			return 0;
+		}
+
+		// unlike std::cin >> x, from_chars says which token was wrong and leaves std::cin usable
+		int x{};
+		const char *first{ token.data() };
+		const char *last{ token.data() + token.size() };
+		// from_chars takes a '-' but not a '+', so skip one (though not in "+-5")
+		if (token.size() > 1 && token[0] == '+' && token[1] != '-')
+			++first;
+		auto [end, error]{ std::from_chars(first, last, x) };
+		if (error == std::errc{} && end == last)
+			return x;
+		if (error == std::errc::result_out_of_range && end == last)
+			std::cerr << token << " doesn't fit in an int, try again.\n";
+		else
+			std::cerr << '"' << token << "\" is not an integer, try again.\n";
+	}
+}
@@ -0,0 +1,512 @@
+#include "add_arrays.h"
+#include "../../cpu_features.h"
+#include "add_overflow.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/* How the path is picked: the widest the CPU (and OS, which has to save the
+wider registers) supports, as cpu_features.h reports it. Detected while the
+program starts up. */
+
+static AddPath detectAddPath()
+{
+    const CpuFeatures &cpu{ cpuFeatures() };
+    if (cpu.avx512f)
+        return AddPath::avx512;
+    if (cpu.avx2)
+        return AddPath::avx2;
+    if (cpu.neon)
+        return AddPath::neon;
+    return AddPath::scalar;
+}
+
+static AddPath g_addPath{ detectAddPath() };
+
+const char *addPathName(AddPath path)
+{
+    switch (path)
+    {
+    case AddPath::avx2:   return "avx2";
+    case AddPath::avx512: return "avx512";
+    case AddPath::neon:   return "neon";
+    default:              return "scalar";
+    }
+}
+
+AddPath activeAddPath()
+{
+    return g_addPath;
+}
+
+void forceAddPath(AddPath path)
+{
+    AddPath best{ detectAddPath() };
+    bool supported{ path == AddPath::scalar || path == best ||
+                    (path == AddPath::avx2 && best == AddPath::avx512) };
+    g_addPath = supported ? path : AddPath::scalar;
+}
+
+
+/* Kernels. Integers are added as unsigned so that overflow wraps, like the
+vector instructions do, instead of being undefined. */
+
+template <typename T>
+static void addScalar(const T *x, const T *y, T *out, std::size_t count)
+{
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        if constexpr (std::is_integral_v<T>)
+            out[i] = static_cast<T>(static_cast<std::make_unsigned_t<T>>(x[i]) + static_cast<std::make_unsigned_t<T>>(y[i]));
+        else
+            out[i] = x[i] + y[i];
+    }
+}
+
+#if defined(SIMD_X86)
+
+template <typename T>
+SIMD_TARGET("avx2")
+static void addAvx2(const T *x, const T *y, T *out, std::size_t count)
+{
+    constexpr std::size_t lanes{ 32 / sizeof(T) };
+    std::size_t i{ 0 };
+    for (; i + lanes <= count; i += lanes)
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        else
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+            __m256i sum = (sizeof(T) == 4) ? _mm256_add_epi32(a, b) : _mm256_add_epi64(a, b);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), sum);
+        }
+    }
+    addScalar(x + i, y + i, out + i, count - i);
+}
+
+// the tail is done with a masked load and store instead of a scalar loop
+template <typename T>
+SIMD_TARGET("avx512f")
+static void addAvx512(const T *x, const T *y, T *out, std::size_t count)
+{
+    constexpr std::size_t lanes{ 64 / sizeof(T) };
+    for (std::size_t i{ 0 }; i < count; i += lanes)
+    {
+        std::size_t left{ count - i };
+        auto mask{ static_cast<__mmask16>(left >= lanes ? 0xFFFF : (1u << left) - 1) };
+
+        if constexpr (std::is_same_v<T, float>)
+        {
+            __m512 sum = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+            _mm512_mask_storeu_ps(out + i, mask, sum);
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            auto mask8{ static_cast<__mmask8>(mask) };
+            __m512d sum = _mm512_add_pd(_mm512_maskz_loadu_pd(mask8, x + i), _mm512_maskz_loadu_pd(mask8, y + i));
+            _mm512_mask_storeu_pd(out + i, mask8, sum);
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            __m512i sum = _mm512_add_epi32(_mm512_maskz_loadu_epi32(mask, x + i), _mm512_maskz_loadu_epi32(mask, y + i));
+            _mm512_mask_storeu_epi32(out + i, mask, sum);
+        }
+        else
+        {
+            auto mask8{ static_cast<__mmask8>(mask) };
+            __m512i sum = _mm512_add_epi64(_mm512_maskz_loadu_epi64(mask8, x + i), _mm512_maskz_loadu_epi64(mask8, y + i));
+            _mm512_mask_storeu_epi64(out + i, mask8, sum);
+        }
+    }
+}
+
+#endif // SIMD_X86
+
+
+#if defined(SIMD_NEON)
+
+template <typename T>
+static void addNeon(const T *x, const T *y, T *out, std::size_t count)
+{
+    constexpr std::size_t lanes{ 16 / sizeof(T) };
+    std::size_t i{ 0 };
+    for (; i + lanes <= count; i += lanes)
+    {
+        if constexpr (std::is_same_v<T, float>)
+            vst1q_f32(out + i, vaddq_f32(vld1q_f32(x + i), vld1q_f32(y + i)));
+        else if constexpr (std::is_same_v<T, double>)
+            vst1q_f64(out + i, vaddq_f64(vld1q_f64(x + i), vld1q_f64(y + i)));
+        else if constexpr (sizeof(T) == 4)
+            vst1q_s32(out + i, vaddq_s32(vld1q_s32(x + i), vld1q_s32(y + i)));
+        else
+            vst1q_s64(out + i, vaddq_s64(vld1q_s64(x + i), vld1q_s64(y + i)));
+    }
+    addScalar(x + i, y + i, out + i, count - i);
+}
+
+#endif // SIMD_NEON
+
+
+/* Saturating and checked kernels. Each vector step works out both the wrapped
+and the saturated sums: the saturating kernel keeps the second, the checked
+kernel stores the first and remembers whether the two ever differed, which is
+exactly when a sum overflowed. */
+
+template <typename T>
+static void addSaturatingScalar(const T *x, const T *y, T *out, std::size_t count)
+{
+    for (std::size_t i{ 0 }; i < count; ++i)
+        out[i] = add_saturating(x[i], y[i]);
+}
+
+template <typename T>
+static bool addCheckedScalar(const T *x, const T *y, T *out, std::size_t count)
+{
+    bool ok{ true };
+    for (std::size_t i{ 0 }; i < count; ++i)
+        ok = add_checked(x[i], y[i], out[i]) && ok;
+    return ok;
+}
+
+#if defined(SIMD_X86)
+
+// all ones in the lanes holding a negative value
+template <typename T>
+SIMD_TARGET("avx2")
+static inline __m256i negativeAvx2(__m256i v)
+{
+    if constexpr (sizeof(T) == 4)
+        return _mm256_srai_epi32(v, 31);
+    else
+        return _mm256_cmpgt_epi64(_mm256_setzero_si256(), v);
+}
+
+template <typename T>
+SIMD_TARGET("avx2")
+static inline void sumsAvx2(__m256i a, __m256i b, __m256i &wrapped, __m256i &saturated)
+{
+    if constexpr (sizeof(T) == 1)
+    {
+        wrapped = _mm256_add_epi8(a, b);
+        saturated = std::is_signed_v<T> ? _mm256_adds_epi8(a, b) : _mm256_adds_epu8(a, b);
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        wrapped = _mm256_add_epi16(a, b);
+        saturated = std::is_signed_v<T> ? _mm256_adds_epi16(a, b) : _mm256_adds_epu16(a, b);
+    }
+    else if constexpr (std::is_signed_v<T>)
+    {
+        wrapped = (sizeof(T) == 4) ? _mm256_add_epi32(a, b) : _mm256_add_epi64(a, b);
+        // a and b have the same sign and the sum has the other one
+        __m256i overflow = negativeAvx2<T>(_mm256_andnot_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, wrapped)));
+        // max when a >= 0, min (all bits of max flipped) when a < 0
+        __m256i max = (sizeof(T) == 4) ? _mm256_set1_epi32(std::numeric_limits<std::int32_t>::max())
+                                        : _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::max());
+        __m256i limit = _mm256_xor_si256(negativeAvx2<T>(a), max);
+        saturated = _mm256_blendv_epi8(wrapped, limit, overflow);
+    }
+    else
+    {
+        wrapped = (sizeof(T) == 4) ? _mm256_add_epi32(a, b) : _mm256_add_epi64(a, b);
+        // the sum wrapped if it came out below a; flipping the top bits lets a signed compare do that
+        __m256i flip = (sizeof(T) == 4) ? _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min())
+                                        : _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min());
+        __m256i biasedA = _mm256_xor_si256(a, flip);
+        __m256i biasedSum = _mm256_xor_si256(wrapped, flip);
+        __m256i overflow = (sizeof(T) == 4) ? _mm256_cmpgt_epi32(biasedA, biasedSum) : _mm256_cmpgt_epi64(biasedA, biasedSum);
+        saturated = _mm256_or_si256(wrapped, overflow);
+    }
+}
+
+template <typename T>
+SIMD_TARGET("avx2")
+static void addSaturatingAvx2(const T *x, const T *y, T *out, std::size_t count)
+{
+    constexpr std::size_t lanes{ 32 / sizeof(T) };
+    std::size_t i{ 0 };
+    for (; i + lanes <= count; i += lanes)
+    {
+        __m256i wrapped, saturated;
+        sumsAvx2<T>(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i)), wrapped, saturated);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), saturated);
+    }
+    addSaturatingScalar(x + i, y + i, out + i, count - i);
+}
+
+template <typename T>
+SIMD_TARGET("avx2")
+static bool addCheckedAvx2(const T *x, const T *y, T *out, std::size_t count)
+{
+    constexpr std::size_t lanes{ 32 / sizeof(T) };
+    __m256i differ = _mm256_setzero_si256();
+    std::size_t i{ 0 };
+    for (; i + lanes <= count; i += lanes)
+    {
+        __m256i wrapped, saturated;
+        sumsAvx2<T>(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i)), wrapped, saturated);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), wrapped);
+        differ = _mm256_or_si256(differ, _mm256_xor_si256(wrapped, saturated));
+    }
+    bool tailOk{ addCheckedScalar(x + i, y + i, out + i, count - i) };
+    return _mm256_testz_si256(differ, differ) != 0 && tailOk;
+}
+
+#endif // SIMD_X86
+
+#if defined(SIMD_NEON)
+
+// NEON has saturating adds for every width
+template <typename T>
+static inline void sumsNeon(const T *x, const T *y, uint8x16_t &wrapped, uint8x16_t &saturated)
+{
+    if constexpr (std::is_same_v<T, std::int8_t>)
+    {
+        int8x16_t a = vld1q_s8(x), b = vld1q_s8(y);
+        wrapped = vreinterpretq_u8_s8(vaddq_s8(a, b));
+        saturated = vreinterpretq_u8_s8(vqaddq_s8(a, b));
+    }
+    else if constexpr (std::is_same_v<T, std::int16_t>)
+    {
+        int16x8_t a = vld1q_s16(x), b = vld1q_s16(y);
+        wrapped = vreinterpretq_u8_s16(vaddq_s16(a, b));
+        saturated = vreinterpretq_u8_s16(vqaddq_s16(a, b));
+    }
+    else if constexpr (std::is_same_v<T, std::int32_t>)
+    {
+        int32x4_t a = vld1q_s32(x), b = vld1q_s32(y);
+        wrapped = vreinterpretq_u8_s32(vaddq_s32(a, b));
+        saturated = vreinterpretq_u8_s32(vqaddq_s32(a, b));
+    }
+    else if constexpr (std::is_same_v<T, std::int64_t>)
+    {
+        int64x2_t a = vld1q_s64(x), b = vld1q_s64(y);
+        wrapped = vreinterpretq_u8_s64(vaddq_s64(a, b));
+        saturated = vreinterpretq_u8_s64(vqaddq_s64(a, b));
+    }
+    else if constexpr (std::is_same_v<T, std::uint8_t>)
+    {
+        uint8x16_t a = vld1q_u8(x), b = vld1q_u8(y);
+        wrapped = vaddq_u8(a, b);
+        saturated = vqaddq_u8(a, b);
+    }
+    else if constexpr (std::is_same_v<T, std::uint16_t>)
+    {
+        uint16x8_t a = vld1q_u16(x), b = vld1q_u16(y);
+        wrapped = vreinterpretq_u8_u16(vaddq_u16(a, b));
+        saturated = vreinterpretq_u8_u16(vqaddq_u16(a, b));
+    }
+    else if constexpr (std::is_same_v<T, std::uint32_t>)
+    {
+        uint32x4_t a = vld1q_u32(x), b = vld1q_u32(y);
+        wrapped = vreinterpretq_u8_u32(vaddq_u32(a, b));
+        saturated = vreinterpretq_u8_u32(vqaddq_u32(a, b));
+    }
+    else
+    {
+        uint64x2_t a = vld1q_u64(x), b = vld1q_u64(y);
+        wrapped = vreinterpretq_u8_u64(vaddq_u64(a, b));
+        saturated = vreinterpretq_u8_u64(vqaddq_u64(a, b));
+    }
+}
+
+template <typename T>
+static void addSaturatingNeon(const T *x, const T *y, T *out, std::size_t count)
+{
+    constexpr std::size_t lanes{ 16 / sizeof(T) };
+    std::size_t i{ 0 };
+    for (; i + lanes <= count; i += lanes)
+    {
+        uint8x16_t wrapped, saturated;
+        sumsNeon(x + i, y + i, wrapped, saturated);
+        vst1q_u8(reinterpret_cast<std::uint8_t *>(out + i), saturated);
+    }
+    addSaturatingScalar(x + i, y + i, out + i, count - i);
+}
+
+template <typename T>
+static bool addCheckedNeon(const T *x, const T *y, T *out, std::size_t count)
+{
+    constexpr std::size_t lanes{ 16 / sizeof(T) };
+    uint8x16_t differ = vdupq_n_u8(0);
+    std::size_t i{ 0 };
+    for (; i + lanes <= count; i += lanes)
+    {
+        uint8x16_t wrapped, saturated;
+        sumsNeon(x + i, y + i, wrapped, saturated);
+        vst1q_u8(reinterpret_cast<std::uint8_t *>(out + i), wrapped);
+        differ = vorrq_u8(differ, veorq_u8(wrapped, saturated));
+    }
+    bool tailOk{ addCheckedScalar(x + i, y + i, out + i, count - i) };
+    return vmaxvq_u8(differ) == 0 && tailOk;
+}
+
+#endif // SIMD_NEON
+
+
+template <typename T>
+static bool addArrays(std::span<const T> x, std::span<const T> y, std::span<T> out)
+{
+    if (x.size() != y.size() || x.size() != out.size())
+        return false;
+
+    switch (activeAddPath())
+    {
+#if defined(SIMD_X86)
+    case AddPath::avx512: addAvx512(x.data(), y.data(), out.data(), out.size()); break;
+    case AddPath::avx2:   addAvx2(x.data(), y.data(), out.data(), out.size()); break;
+#elif defined(SIMD_NEON)
+    case AddPath::neon:   addNeon(x.data(), y.data(), out.data(), out.size()); break;
+#endif
+    default:              addScalar(x.data(), y.data(), out.data(), out.size()); break;
+    }
+    return true;
+}
+
+bool add_arrays(std::span<const std::int32_t> x, std::span<const std::int32_t> y, std::span<std::int32_t> out)
+{
+    return addArrays(x, y, out);
+}
+
+bool add_arrays(std::span<const std::int64_t> x, std::span<const std::int64_t> y, std::span<std::int64_t> out)
+{
+    return addArrays(x, y, out);
+}
+
+bool add_arrays(std::span<const float> x, std::span<const float> y, std::span<float> out)
+{
+    return addArrays(x, y, out);
+}
+
+bool add_arrays(std::span<const double> x, std::span<const double> y, std::span<double> out)
+{
+    return addArrays(x, y, out);
+}
+
+template <typename T>
+static bool addArraysSaturating(std::span<const T> x, std::span<const T> y, std::span<T> out)
+{
+    if (x.size() != y.size() || x.size() != out.size())
+        return false;
+
+    switch (activeAddPath())
+    {
+#if defined(SIMD_X86)
+    case AddPath::avx512:
+    case AddPath::avx2:   addSaturatingAvx2(x.data(), y.data(), out.data(), out.size()); break;
+#elif defined(SIMD_NEON)
+    case AddPath::neon:   addSaturatingNeon(x.data(), y.data(), out.data(), out.size()); break;
+#endif
+    default:              addSaturatingScalar(x.data(), y.data(), out.data(), out.size()); break;
+    }
+    return true;
+}
+
+template <typename T>
+static bool addArraysChecked(std::span<const T> x, std::span<const T> y, std::span<T> out)
+{
+    if (x.size() != y.size() || x.size() != out.size())
+        return false;
+
+    switch (activeAddPath())
+    {
+#if defined(SIMD_X86)
+    case AddPath::avx512:
+    case AddPath::avx2:   return addCheckedAvx2(x.data(), y.data(), out.data(), out.size());
+#elif defined(SIMD_NEON)
+    case AddPath::neon:   return addCheckedNeon(x.data(), y.data(), out.data(), out.size());
+#endif
+    default:              return addCheckedScalar(x.data(), y.data(), out.data(), out.size());
+    }
+}
+
+bool add_arrays_saturating(std::span<const std::int8_t> x, std::span<const std::int8_t> y, std::span<std::int8_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_saturating(std::span<const std::int16_t> x, std::span<const std::int16_t> y, std::span<std::int16_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_saturating(std::span<const std::int32_t> x, std::span<const std::int32_t> y, std::span<std::int32_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_saturating(std::span<const std::int64_t> x, std::span<const std::int64_t> y, std::span<std::int64_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_saturating(std::span<const std::uint8_t> x, std::span<const std::uint8_t> y, std::span<std::uint8_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_saturating(std::span<const std::uint16_t> x, std::span<const std::uint16_t> y, std::span<std::uint16_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_saturating(std::span<const std::uint32_t> x, std::span<const std::uint32_t> y, std::span<std::uint32_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_saturating(std::span<const std::uint64_t> x, std::span<const std::uint64_t> y, std::span<std::uint64_t> out)
+{
+    return addArraysSaturating(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::int8_t> x, std::span<const std::int8_t> y, std::span<std::int8_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::int16_t> x, std::span<const std::int16_t> y, std::span<std::int16_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::int32_t> x, std::span<const std::int32_t> y, std::span<std::int32_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::int64_t> x, std::span<const std::int64_t> y, std::span<std::int64_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::uint8_t> x, std::span<const std::uint8_t> y, std::span<std::uint8_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::uint16_t> x, std::span<const std::uint16_t> y, std::span<std::uint16_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::uint32_t> x, std::span<const std::uint32_t> y, std::span<std::uint32_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
+
+bool add_arrays_checked(std::span<const std::uint64_t> x, std::span<const std::uint64_t> y, std::span<std::uint64_t> out)
+{
+    return addArraysChecked(x, y, out);
+}
@@ -0,0 +1,67 @@
+#ifndef ADD_ARRAYS_H
+#define ADD_ARRAYS_H
+
+/* Element-wise addition of whole arrays: out[i] = x[i] + y[i].
+
+add() lives in add.cpp, so a loop over add() is a function call per element
+that the compiler can neither inline nor vectorize. add_arrays does the whole
+array in one call, with AVX-512 or AVX2 on x86, NEON on ARM64, or a plain loop.
+The widest kernel the CPU supports is picked at runtime.
+
+Every kernel does exactly the same additions in the same order, so results don't
+depend on the path: integers wrap around the same way, and floating-point sums
+are the IEEE-rounded x[i] + y[i] that a scalar add gives (the kernels never fuse
+or reassociate). For ints in range the result matches add(x[i], y[i]).
+
+x, y and out must all have the same size; otherwise nothing is written and
+false is returned. out may be x or y.
+
+The integer sums can also be saturating or checked (see add_overflow.h):
+add_arrays_saturating clamps every sum to the range of the type, and
+add_arrays_checked writes the wrapped sums and returns false if any of them
+overflowed (or if the sizes don't match). The 8- and 16-bit kernels use the
+saturating add instructions; x86 has none for 32 and 64 bits, so there the
+overflow is worked out from the signs. These use the AVX2 kernels on AVX-512
+CPUs too. */
+
+#include <cstdint>
+#include <span>
+
+enum class AddPath
+{
+    scalar,
+    avx2,
+    avx512,
+    neon,
+};
+
+const char *addPathName(AddPath path);
+
+// the path add_arrays uses; forceAddPath narrows it, e.g. to compare paths
+AddPath activeAddPath();
+void forceAddPath(AddPath path);
+
+bool add_arrays(std::span<const std::int32_t> x, std::span<const std::int32_t> y, std::span<std::int32_t> out);
+bool add_arrays(std::span<const std::int64_t> x, std::span<const std::int64_t> y, std::span<std::int64_t> out);
+bool add_arrays(std::span<const float> x, std::span<const float> y, std::span<float> out);
+bool add_arrays(std::span<const double> x, std::span<const double> y, std::span<double> out);
+
+bool add_arrays_saturating(std::span<const std::int8_t> x, std::span<const std::int8_t> y, std::span<std::int8_t> out);
+bool add_arrays_saturating(std::span<const std::int16_t> x, std::span<const std::int16_t> y, std::span<std::int16_t> out);
+bool add_arrays_saturating(std::span<const std::int32_t> x, std::span<const std::int32_t> y, std::span<std::int32_t> out);
+bool add_arrays_saturating(std::span<const std::int64_t> x, std::span<const std::int64_t> y, std::span<std::int64_t> out);
+bool add_arrays_saturating(std::span<const std::uint8_t> x, std::span<const std::uint8_t> y, std::span<std::uint8_t> out);
+bool add_arrays_saturating(std::span<const std::uint16_t> x, std::span<const std::uint16_t> y, std::span<std::uint16_t> out);
+bool add_arrays_saturating(std::span<const std::uint32_t> x, std::span<const std::uint32_t> y, std::span<std::uint32_t> out);
+bool add_arrays_saturating(std::span<const std::uint64_t> x, std::span<const std::uint64_t> y, std::span<std::uint64_t> out);
+
+bool add_arrays_checked(std::span<const std::int8_t> x, std::span<const std::int8_t> y, std::span<std::int8_t> out);
+bool add_arrays_checked(std::span<const std::int16_t> x, std::span<const std::int16_t> y, std::span<std::int16_t> out);
+bool add_arrays_checked(std::span<const std::int32_t> x, std::span<const std::int32_t> y, std::span<std::int32_t> out);
+bool add_arrays_checked(std::span<const std::int64_t> x, std::span<const std::int64_t> y, std::span<std::int64_t> out);
+bool add_arrays_checked(std::span<const std::uint8_t> x, std::span<const std::uint8_t> y, std::span<std::uint8_t> out);
+bool add_arrays_checked(std::span<const std::uint16_t> x, std::span<const std::uint16_t> y, std::span<std::uint16_t> out);
+bool add_arrays_checked(std::span<const std::uint32_t> x, std::span<const std::uint32_t> y, std::span<std::uint32_t> out);
+bool add_arrays_checked(std::span<const std::uint64_t> x, std::span<const std::uint64_t> y, std::span<std::uint64_t> out);
+
+#endif
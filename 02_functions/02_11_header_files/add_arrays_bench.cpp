@@ -0,0 +1,283 @@
+/* Compares add_arrays with a loop over add().
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 add_arrays_bench.cpp add_arrays.cpp add.cpp -o add_arrays_bench
+
+For arrays that fit in L1, in L2 and only in memory, it prints the time per
+element and the bandwidth (two arrays read, one written) of the add() loop and
+of add_arrays on every path the CPU supports, and checks every result against
+add(). For the integer types it also times the saturating and checked versions,
+e.g. to compare checked int32 sums with widening everything to int64.
+
+Those sizes are all multiples of every vector width, so before timing anything
+it also runs every path on short and odd lengths (1, 7, 33, 1023, ...), where the
+masked AVX-512 tail and the scalar tails of the other kernels do part of the
+work, and checks that they match a plain loop and write nothing past the end.
+The saturating and checked versions get the same lengths for all eight integer
+types, with operands at and next to the type's limits so that sums overflow in
+both directions, checked against add_saturating and add_checked one pair at a
+time. */
+
+#include "add.h"
+#include "add_arrays.h"
+#include "add_overflow.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template <typename Body>
+double nsPerElement(std::size_t count, Body body)
+{
+    // repeat until about 256 MiB have been added, so small arrays are timed long enough
+    std::size_t rounds{ (std::size_t{ 256 } << 20) / (count * sizeof(std::int32_t)) + 1 };
+    body(); // warm up the caches
+
+    auto start{ std::chrono::steady_clock::now() };
+    for (std::size_t r{ 0 }; r < rounds; ++r)
+        body();
+    double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+    return seconds * 1e9 / static_cast<double>(rounds * count);
+}
+
+void print(const char *name, double ns, std::size_t elementSize)
+{
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(3) << std::setw(8)
+              << ns << " ns/element " << std::setprecision(1) << std::setw(8) << 3.0 * elementSize / ns
+              << " GB/s\n";
+}
+
+// shorter than one vector, one either side of a vector's length, and long with a ragged end
+constexpr std::size_t oddLengths[]{ 1, 3, 7, 9, 15, 17, 31, 33, 63, 65, 1023 };
+
+// any value of T, from two draws so 64-bit types get all their bits
+template <typename T>
+T randomValue(std::mt19937 &rng)
+{
+    std::uint64_t bits{ (std::uint64_t{ rng() } << 32) | rng() };
+    if constexpr (std::is_integral_v<T>)
+        return static_cast<T>(bits);
+    else
+        return static_cast<T>(static_cast<std::int64_t>(bits)) / static_cast<T>(1 << 20);
+}
+
+// add_arrays on every path and every odd length against one add at a time; out has a guard element past the end
+template <typename T>
+bool checkLengths(const char *typeName, std::mt19937 &rng)
+{
+    bool ok{ true };
+    AddPath best{ activeAddPath() };
+    for (std::size_t count : oddLengths)
+    {
+        std::vector<T> x(count), y(count), expected(count);
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            x[i] = randomValue<T>(rng);
+            y[i] = randomValue<T>(rng);
+            if constexpr (std::is_integral_v<T>)
+                expected[i] = add_wrapping(x[i], y[i]);
+            else
+                expected[i] = x[i] + y[i];
+        }
+
+        for (AddPath path : { AddPath::scalar, AddPath::avx2, AddPath::avx512, AddPath::neon })
+        {
+            forceAddPath(path);
+            if (activeAddPath() != path)
+                continue;
+
+            const T guard{ 77 };
+            std::vector<T> out(count + 1, guard);
+            bool sameSize{ add_arrays(x, y, std::span<T>{ out.data(), count }) };
+            if (!sameSize || !std::equal(expected.begin(), expected.end(), out.begin()) || out[count] != guard)
+            {
+                std::cerr << "add_arrays<" << typeName << "> " << addPathName(path) << " is wrong for " << count
+                          << " elements\n";
+                ok = false;
+            }
+        }
+    }
+    forceAddPath(best);
+    return ok;
+}
+
+// the limits of T and their neighbours, 0 and 1, or now and then any value at all
+template <typename T>
+T edgeValue(std::mt19937 &rng)
+{
+    constexpr T low{ std::numeric_limits<T>::min() };
+    constexpr T high{ std::numeric_limits<T>::max() };
+    const T edges[]{ low, static_cast<T>(low + 1), static_cast<T>(high - 1), high, T{ 0 }, T{ 1 }, static_cast<T>(-1) };
+    std::size_t pick{ rng() % (std::size(edges) + 1) };
+    return pick < std::size(edges) ? edges[pick] : randomValue<T>(rng);
+}
+
+/* add_arrays_saturating and add_arrays_checked on every path and every odd
+length, against add_saturating and add_checked one pair at a time. Each length
+gets three rounds: edge operands, where most sums overflow; the same halved, so
+none do and checked has to return true; and halved with only the last pair
+overflowing, which lands in the tail. */
+template <typename T>
+bool checkOverflow(const char *typeName, std::mt19937 &rng)
+{
+    bool ok{ true };
+    AddPath best{ activeAddPath() };
+    for (std::size_t count : oddLengths)
+    {
+        for (int round{ 0 }; round < 3; ++round)
+        {
+            std::vector<T> x(count), y(count);
+            for (std::size_t i{ 0 }; i < count; ++i)
+            {
+                x[i] = edgeValue<T>(rng);
+                y[i] = edgeValue<T>(rng);
+                if (round > 0)
+                {
+                    x[i] = static_cast<T>(x[i] / 2);
+                    y[i] = static_cast<T>(y[i] / 2);
+                }
+            }
+            if (round == 2)
+            {
+                x[count - 1] = std::numeric_limits<T>::max();
+                y[count - 1] = 1;
+            }
+
+            std::vector<T> saturated(count), wrapped(count);
+            bool fits{ true };
+            for (std::size_t i{ 0 }; i < count; ++i)
+            {
+                saturated[i] = add_saturating(x[i], y[i]);
+                fits = add_checked(x[i], y[i], wrapped[i]) && fits;
+            }
+
+            for (AddPath path : { AddPath::scalar, AddPath::avx2, AddPath::avx512, AddPath::neon })
+            {
+                forceAddPath(path);
+                if (activeAddPath() != path)
+                    continue;
+
+                std::vector<T> out(count);
+                if (!add_arrays_saturating(x, y, out) || out != saturated)
+                {
+                    std::cerr << "add_arrays_saturating<" << typeName << "> " << addPathName(path)
+                              << " is wrong for " << count << " elements\n";
+                    ok = false;
+                }
+                if (add_arrays_checked(x, y, out) != fits || out != wrapped)
+                {
+                    std::cerr << "add_arrays_checked<" << typeName << "> " << addPathName(path) << " is wrong for "
+                              << count << " elements" << (fits ? "" : " that overflow") << '\n';
+                    ok = false;
+                }
+            }
+        }
+    }
+    forceAddPath(best);
+    return ok;
+}
+
+template <typename T>
+bool benchType(const char *typeName, std::size_t count, std::mt19937 &rng)
+{
+    std::vector<T> x(count), y(count), out(count), expected(count);
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        x[i] = static_cast<T>(static_cast<std::int32_t>(rng()) / 2);
+        y[i] = static_cast<T>(static_cast<std::int32_t>(rng()) / 2);
+        // add() takes ints; halving keeps every sum in range so the integer results match it exactly
+        if constexpr (std::is_integral_v<T>)
+            expected[i] = static_cast<T>(add(static_cast<int>(x[i]), static_cast<int>(y[i])));
+        else
+            expected[i] = x[i] + y[i];
+    }
+
+    AddPath best{ activeAddPath() };
+    bool ok{ true };
+    for (AddPath path : { AddPath::scalar, AddPath::avx2, AddPath::avx512, AddPath::neon })
+    {
+        forceAddPath(path);
+        if (activeAddPath() != path)
+            continue;
+
+        double ns{ nsPerElement(count, [&] { add_arrays(x, y, out); }) };
+        std::string name{ std::string{ "add_arrays<" } + typeName + "> " + addPathName(path) };
+        print(name.c_str(), ns, sizeof(T));
+        ok = ok && out == expected;
+
+        if constexpr (std::is_integral_v<T>)
+        {
+            ns = nsPerElement(count, [&] { add_arrays_saturating(x, y, out); });
+            print((name + " saturating").c_str(), ns, sizeof(T));
+            ok = ok && out == expected;
+
+            bool fits{ true };
+            ns = nsPerElement(count, [&] { fits = add_arrays_checked(x, y, out); });
+            print((name + " checked").c_str(), ns, sizeof(T));
+            ok = ok && fits && out == expected;
+        }
+    }
+    forceAddPath(best);
+    return ok;
+}
+
+int main()
+{
+    std::mt19937 rng{ 42 };
+    bool ok{ true };
+
+    ok = checkLengths<std::int32_t>("int32", rng) && ok;
+    ok = checkLengths<std::int64_t>("int64", rng) && ok;
+    ok = checkLengths<float>("float", rng) && ok;
+    ok = checkLengths<double>("double", rng) && ok;
+    ok = checkOverflow<std::int8_t>("int8", rng) && ok;
+    ok = checkOverflow<std::int16_t>("int16", rng) && ok;
+    ok = checkOverflow<std::int32_t>("int32", rng) && ok;
+    ok = checkOverflow<std::int64_t>("int64", rng) && ok;
+    ok = checkOverflow<std::uint8_t>("uint8", rng) && ok;
+    ok = checkOverflow<std::uint16_t>("uint16", rng) && ok;
+    ok = checkOverflow<std::uint32_t>("uint32", rng) && ok;
+    ok = checkOverflow<std::uint64_t>("uint64", rng) && ok;
+    if (!ok)
+    {
+        std::cerr << "add_arrays is wrong on short, odd or overflowing input, not timing it\n";
+        return 1;
+    }
+
+    for (std::size_t count : { std::size_t{ 1 } << 10, std::size_t{ 1 } << 15, std::size_t{ 1 } << 24 })
+    {
+        std::cout << "\n" << count << " elements (" << count * 3 * sizeof(std::int32_t) / 1024 << " KiB of int32)\n";
+
+        std::vector<int> x(count), y(count), out(count);
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            x[i] = static_cast<int>(rng()) / 2;
+            y[i] = static_cast<int>(rng()) / 2;
+        }
+        double ns{ nsPerElement(count, [&] {
+            for (std::size_t i{ 0 }; i < count; ++i)
+                out[i] = add(x[i], y[i]);
+        }) };
+        print("add() loop", ns, sizeof(int));
+
+        ok = benchType<std::int32_t>("int32", count, rng) && ok;
+        ok = benchType<std::int64_t>("int64", count, rng) && ok;
+        ok = benchType<float>("float", count, rng) && ok;
+        ok = benchType<double>("double", count, rng) && ok;
+    }
+
+    if (!ok)
+    {
+        std::cerr << "add_arrays doesn't match add()!\n";
+        return 1;
+    }
+    return 0;
+}
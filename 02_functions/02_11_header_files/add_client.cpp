@@ -0,0 +1,159 @@
+/* Load generator for add_service.
+
+Opens one connection per simulated client, each on its own thread. Every client
+sends a request, waits for the reply, checks every sum and overflow flag against
+add_checked and sends the next one, so the latency of each round trip can be
+measured on its own. The operands span the whole int range, so about a quarter
+of the pairs overflow. At the end it prints the p50/p99/max latency over all
+requests and the overall request and pair rates.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 -pthread add_client.cpp -o add_client
+
+Usage:
+add_client [socket] [clients] [requests] [pairs]
+    socket     default /tmp/add_service.sock
+    clients    concurrent connections (default 8)
+    requests   requests per client (default 10000)
+    pairs      pairs per request (default 64) */
+
+#include "add_overflow.h"
+#include "add_protocol.h"
+#include <iostream>
+
+#if defined(_WIN32)
+
+int main()
+{
+    std::cerr << "add_client needs Unix domain sockets, which this build doesn't support\n";
+    return 1;
+}
+
+#else
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct ClientResult
+{
+    std::vector<double> latencies; // microseconds, one per request
+    bool ok{ true };
+};
+
+ClientResult runClient(const char *path, unsigned seed, std::size_t requests, std::uint32_t pairs)
+{
+    ClientResult result{};
+    result.latencies.reserve(requests);
+
+    sockaddr_un address{};
+    socklen_t addressLength{};
+    int fd{ ::socket(AF_UNIX, SOCK_STREAM, 0) };
+    if (fd < 0 || !makeSocketAddress(path, address, addressLength) ||
+        ::connect(fd, reinterpret_cast<sockaddr *>(&address), addressLength) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        result.ok = false;
+        return result;
+    }
+
+    // the request is the count followed by the pairs, sent with one call
+    std::vector<char> request(requestSize(pairs));
+    std::vector<std::int32_t> sums(pairs);
+    std::vector<std::uint32_t> overflowed(overflowWords(pairs));
+    std::vector<AddPair> operands(pairs);
+    std::mt19937 rng{ seed };
+    std::uniform_int_distribution<std::int32_t> operand{ std::numeric_limits<std::int32_t>::min(),
+                                                         std::numeric_limits<std::int32_t>::max() };
+
+    for (std::size_t r{ 0 }; r < requests && result.ok; ++r)
+    {
+        for (AddPair &pair : operands)
+            pair = { operand(rng), operand(rng) };
+        std::memcpy(request.data(), &pairs, sizeof(pairs));
+        std::memcpy(request.data() + sizeof(pairs), operands.data(), pairs * sizeof(AddPair));
+
+        auto start{ std::chrono::steady_clock::now() };
+        std::uint32_t count{};
+        result.ok = sendAll(fd, request.data(), request.size()) && receiveAll(fd, &count, sizeof(count)) &&
+                    count == pairs && receiveAll(fd, sums.data(), pairs * sizeof(std::int32_t)) &&
+                    receiveAll(fd, overflowed.data(), overflowed.size() * sizeof(std::uint32_t));
+        auto stop{ std::chrono::steady_clock::now() };
+        result.latencies.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+
+        for (std::uint32_t i{ 0 }; i < pairs && result.ok; ++i)
+        {
+            std::int32_t sum{};
+            bool fits{ add_checked(operands[i].x, operands[i].y, sum) };
+            bool flagged{ ((overflowed[i / 32] >> (i % 32)) & 1) != 0 };
+            result.ok = sums[i] == sum && flagged == !fits;
+        }
+    }
+
+    ::close(fd);
+    return result;
+}
+
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    auto index{ static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5) };
+    return sorted[index];
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path{ argc > 1 ? argv[1] : defaultAddSocket };
+    std::size_t clients{ argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 8 };
+    std::size_t requests{ argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10'000 };
+    auto pairs{ static_cast<std::uint32_t>(argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 64) };
+    if (clients == 0 || pairs == 0 || pairs > maxPairsPerRequest)
+    {
+        std::cerr << "need at least one client, and 1 to " << maxPairsPerRequest << " pairs per request\n";
+        return 1;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<ClientResult> results(clients);
+    auto start{ std::chrono::steady_clock::now() };
+    {
+        std::vector<std::thread> threads;
+        for (std::size_t c{ 0 }; c < clients; ++c)
+            threads.emplace_back([&, c] { results[c] = runClient(path, static_cast<unsigned>(c + 1), requests, pairs); });
+        for (std::thread &thread : threads)
+            thread.join();
+    }
+    double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+    std::vector<double> latencies;
+    bool ok{ true };
+    for (const ClientResult &result : results)
+    {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        ok = ok && result.ok;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    auto total{ static_cast<double>(latencies.size()) };
+    std::cout << clients << " clients x " << requests << " requests x " << pairs << " pairs in " << seconds << " s\n"
+              << "latency p50 " << percentile(latencies, 0.50) << " us, p99 " << percentile(latencies, 0.99)
+              << " us, max " << (latencies.empty() ? 0.0 : latencies.back()) << " us\n"
+              << total / seconds << " requests/s, " << total * pairs / seconds << " pairs/s\n";
+
+    if (!ok)
+    {
+        std::cerr << "some requests failed or came back wrong (is add_service running on " << path << "?)\n";
+        return 1;
+    }
+    return 0;
+}
+
+#endif
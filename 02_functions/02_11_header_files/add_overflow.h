@@ -0,0 +1,61 @@
+#ifndef ADD_OVERFLOW_H
+#define ADD_OVERFLOW_H
+
+/* Additions that say what happens when the sum doesn't fit.
+
+add() does a plain x + y, and signed overflow is undefined behavior (see lesson
+04.04): the compiler may assume it never happens. These variants work for every
+fixed-width integer type, signed or unsigned, and are always defined:
+
+add_checked     computes the sum and reports whether it fit; if it didn't, sum
+                holds the wrapped value
+add_saturating  clamps to the smallest or largest value of the type
+add_wrapping    wraps around modulo 2^bits, like the hardware does
+
+With these, values that fit in 32 bits can stay in 32 bits instead of being
+widened to 64 just in case. add_arrays.h has batch versions. */
+
+#include <concepts>
+#include <limits>
+#include <type_traits>
+
+template <typename T>
+concept FixedWidthInteger = std::integral<T> && !std::same_as<T, bool>;
+
+template <FixedWidthInteger T>
+constexpr T add_wrapping(T x, T y)
+{
+    // unsigned arithmetic wraps by definition, and since C++20 converting back to signed does too
+    using Unsigned = std::make_unsigned_t<T>;
+    return static_cast<T>(static_cast<Unsigned>(static_cast<Unsigned>(x) + static_cast<Unsigned>(y)));
+}
+
+// true if x + y fits in T
+template <FixedWidthInteger T>
+constexpr bool add_checked(T x, T y, T &sum)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_add_overflow(x, y, &sum);
+#else
+    sum = add_wrapping(x, y);
+    if constexpr (std::is_signed_v<T>)
+        return ((x ^ sum) & (y ^ sum)) >= 0; // overflow flips the sign away from both operands
+    else
+        return sum >= x;
+#endif
+}
+
+template <FixedWidthInteger T>
+constexpr T add_saturating(T x, T y)
+{
+    T sum{};
+    if (add_checked(x, y, sum))
+        return sum;
+    // only two operands of the same sign can overflow, towards that sign
+    if constexpr (std::is_signed_v<T>)
+        return x < 0 ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+    else
+        return std::numeric_limits<T>::max();
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef ADD_PROTOCOL_H
+#define ADD_PROTOCOL_H
+
+/* Wire format shared by add_service and add_client.
+
+A request is a 4-byte pair count n followed by n pairs of 4-byte ints. The reply
+is the same count, then n sums, then overflowWords(n) 4-byte words of overflow
+flags: bit i % 32 of word i / 32 is set when pair i didn't fit in an int, and its
+sum is then the wrapped value (see add_checked in add_overflow.h). Everything is
+in the host's byte order, since both ends always run on the same machine. */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+constexpr const char *defaultAddSocket{ "/tmp/add_service.sock" };
+
+// a request with more pairs than this is refused and its connection closed
+constexpr std::uint32_t maxPairsPerRequest{ 1 << 16 };
+
+struct AddPair
+{
+    std::int32_t x;
+    std::int32_t y;
+};
+
+// number of 32-bit overflow flag words after the sums in a reply
+constexpr std::uint32_t overflowWords(std::uint32_t pairs)
+{
+    return pairs / 32 + (pairs % 32 != 0);
+}
+
+// bytes in a request of that many pairs, and in its reply
+constexpr std::size_t requestSize(std::uint32_t pairs)
+{
+    return sizeof(std::uint32_t) + std::size_t{ pairs } * sizeof(AddPair);
+}
+
+constexpr std::size_t replySize(std::uint32_t pairs)
+{
+    return sizeof(std::uint32_t) + std::size_t{ pairs } * sizeof(std::int32_t) +
+           std::size_t{ overflowWords(pairs) } * sizeof(std::uint32_t);
+}
+
+#if !defined(_WIN32)
+
+// fills in a sockaddr_un for path; false if path doesn't fit
+inline bool makeSocketAddress(const char *path, sockaddr_un &address, socklen_t &length)
+{
+    address = {};
+    address.sun_family = AF_UNIX;
+
+    std::size_t size{ std::strlen(path) };
+    if (size >= sizeof(address.sun_path))
+        return false;
+
+    std::memcpy(address.sun_path, path, size);
+    length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + size + 1);
+    return true;
+}
+
+// blocking write of every byte; false if the peer went away (ignore SIGPIPE to get here)
+inline bool sendAll(int fd, const void *data, std::size_t size)
+{
+    const char *bytes{ static_cast<const char *>(data) };
+    while (size)
+    {
+        ssize_t sent{ ::send(fd, bytes, size, 0) };
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        bytes += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+// blocking read of exactly size bytes; false at end of stream or on error
+inline bool receiveAll(int fd, void *data, std::size_t size)
+{
+    char *bytes{ static_cast<char *>(data) };
+    while (size)
+    {
+        ssize_t received{ ::recv(fd, bytes, size, 0) };
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        bytes += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,401 @@
+/* add() as a long-lived local service.
+
+Starting a process per addition costs far more than the addition. add_service
+starts once, listens on a Unix domain socket and answers batched requests (see
+add_protocol.h) from any number of clients with one thread: every socket is
+non-blocking and an event loop wakes up for whichever ones are ready. On Linux
+the loop sits on epoll; elsewhere (macOS, the BSDs) it falls back to poll().
+
+The sums are done with add_checked rather than add(), since an int overflowing
+in add() is undefined behavior and the operands come from outside; the reply
+flags every pair that overflowed. Each connection buffers at most one largest
+request on the way in and about a megabyte of replies on the way out: a client
+that sends faster than it reads stops being read from until it catches up, so
+the socket pushes back on it instead of the service's memory growing. A client
+that shuts down its side of the socket still gets every reply it asked for: the
+connection closes once the last one has gone out.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 add_service.cpp -o add_service
+
+Usage:
+add_service [socket]   default /tmp/add_service.sock; Ctrl+C stops it */
+
+#include "add_overflow.h"
+#include "add_protocol.h"
+#include <iostream>
+
+#if defined(_WIN32)
+
+int main()
+{
+    std::cerr << "add_service needs Unix domain sockets, which this build doesn't support\n";
+    return 1;
+}
+
+#else
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+// what the event loop reports for one ready socket
+struct Event
+{
+    int fd;
+    bool readable;
+    bool writable;
+};
+
+/* Waits on many sockets at once. A socket is watched for input unless its
+connection's input buffer is full or the client has finished sending, and for
+output only while a reply is stuck in a full socket buffer. */
+class Poller
+{
+public:
+    Poller()
+    {
+#if defined(__linux__)
+        m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+#endif
+    }
+
+    ~Poller()
+    {
+#if defined(__linux__)
+        ::close(m_epoll);
+#endif
+    }
+
+    Poller(const Poller &) = delete;
+    Poller &operator=(const Poller &) = delete;
+
+    bool ok() const
+    {
+#if defined(__linux__)
+        return m_epoll >= 0;
+#else
+        return true;
+#endif
+    }
+
+    void add(int fd)
+    {
+#if defined(__linux__)
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+#else
+        m_fds.push_back({ fd, POLLIN, 0 });
+#endif
+    }
+
+    void watch(int fd, bool reads, bool writes)
+    {
+#if defined(__linux__)
+        epoll_event event{};
+        event.events = (reads ? EPOLLIN : 0u) | (writes ? EPOLLOUT : 0u);
+        event.data.fd = fd;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event);
+#else
+        for (pollfd &entry : m_fds)
+        {
+            if (entry.fd == fd)
+                entry.events = static_cast<short>((reads ? POLLIN : 0) | (writes ? POLLOUT : 0));
+        }
+#endif
+    }
+
+    void remove(int fd)
+    {
+#if defined(__linux__)
+        ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+#else
+        std::erase_if(m_fds, [fd](const pollfd &entry) { return entry.fd == fd; });
+#endif
+    }
+
+    // blocks until at least one socket is ready; false if interrupted by a signal
+    bool wait(std::vector<Event> &ready)
+    {
+        ready.clear();
+#if defined(__linux__)
+        epoll_event events[64];
+        int count{ ::epoll_wait(m_epoll, events, 64, -1) };
+        if (count < 0)
+            return false;
+        for (int i{ 0 }; i < count; ++i)
+        {
+            bool failed{ (events[i].events & (EPOLLERR | EPOLLHUP)) != 0 };
+            ready.push_back({ events[i].data.fd, (events[i].events & EPOLLIN) || failed,
+                              (events[i].events & EPOLLOUT) != 0 });
+        }
+#else
+        if (::poll(m_fds.data(), static_cast<nfds_t>(m_fds.size()), -1) < 0)
+            return false;
+        for (const pollfd &entry : m_fds)
+        {
+            bool failed{ (entry.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0 };
+            if (entry.revents)
+                ready.push_back({ entry.fd, (entry.revents & POLLIN) || failed, (entry.revents & POLLOUT) != 0 });
+        }
+#endif
+        return true;
+    }
+
+private:
+#if defined(__linux__)
+    int m_epoll{ -1 };
+#else
+    std::vector<pollfd> m_fds;
+#endif
+};
+
+// per-connection buffer limits: the largest request fits in the input, and a few of the largest replies in the output
+constexpr std::size_t maxInputBytes{ requestSize(maxPairsPerRequest) };
+constexpr std::size_t maxOutputBytes{ 1 << 20 };
+static_assert(maxOutputBytes >= replySize(maxPairsPerRequest));
+
+struct Connection
+{
+    std::vector<char> input;  // received bytes not yet part of a whole request
+    std::vector<char> output; // reply bytes the socket hasn't taken yet
+    std::size_t sent{ 0 };    // how much of output has gone out
+    bool peerDone{ false };   // the client has shut down its side: no more requests are coming
+    bool watchingReads{ true };
+    bool watchingWrites{ false };
+};
+
+/* Answers the whole requests in connection.input, as long as their replies fit
+under maxOutputBytes; the rest wait until the output drains. False if a request
+is too large. */
+bool answerRequests(Connection &connection)
+{
+    std::size_t pos{ 0 };
+    while (connection.input.size() - pos >= sizeof(std::uint32_t))
+    {
+        std::uint32_t pairs{};
+        std::memcpy(&pairs, connection.input.data() + pos, sizeof(pairs));
+        if (pairs > maxPairsPerRequest)
+            return false;
+
+        std::size_t size{ requestSize(pairs) };
+        if (connection.input.size() - pos < size)
+            break; // the rest of this request hasn't arrived yet
+
+        std::size_t replyAt{ connection.output.size() };
+        if (replyAt + replySize(pairs) > maxOutputBytes)
+            break; // the client isn't keeping up with its replies
+
+        connection.output.resize(replyAt + replySize(pairs));
+        char *reply{ connection.output.data() + replyAt };
+        std::memcpy(reply, &pairs, sizeof(pairs));
+        char *sums{ reply + sizeof(pairs) };
+        char *flags{ sums + pairs * sizeof(std::int32_t) };
+
+        const char *request{ connection.input.data() + pos + sizeof(pairs) };
+        std::uint32_t overflowed{ 0 };
+        for (std::uint32_t i{ 0 }; i < pairs; ++i)
+        {
+            AddPair pair{};
+            std::memcpy(&pair, request + i * sizeof(AddPair), sizeof(pair));
+            std::int32_t sum{};
+            if (!add_checked(pair.x, pair.y, sum))
+                overflowed |= std::uint32_t{ 1 } << (i % 32);
+            std::memcpy(sums + i * sizeof(sum), &sum, sizeof(sum));
+
+            if (i % 32 == 31 || i + 1 == pairs)
+            {
+                std::memcpy(flags + i / 32 * sizeof(overflowed), &overflowed, sizeof(overflowed));
+                overflowed = 0;
+            }
+        }
+        pos += size;
+    }
+
+    connection.input.erase(connection.input.begin(), connection.input.begin() + static_cast<std::ptrdiff_t>(pos));
+    return true;
+}
+
+// writes as much pending output as the socket takes; false if the client went away
+bool flushOutput(int fd, Connection &connection)
+{
+    while (connection.sent < connection.output.size())
+    {
+        ssize_t sent{ ::send(fd, connection.output.data() + connection.sent,
+                             connection.output.size() - connection.sent, 0) };
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true; // full socket buffer: wait for the poller to say it's writable
+        if (sent <= 0)
+            return false;
+        connection.sent += static_cast<std::size_t>(sent);
+    }
+    connection.output.clear();
+    connection.sent = 0;
+    return true;
+}
+
+// reads what is available, up to maxInputBytes in all; false on error, and at end of stream sets peerDone
+bool readInput(int fd, Connection &connection)
+{
+    char block[64 * 1024];
+    while (connection.input.size() < maxInputBytes)
+    {
+        std::size_t room{ std::min(sizeof(block), maxInputBytes - connection.input.size()) };
+        ssize_t received{ ::recv(fd, block, room, 0) };
+        if (received > 0)
+        {
+            connection.input.insert(connection.input.end(), block, block + received);
+            continue;
+        }
+        if (received == 0)
+        {
+            connection.peerDone = true;
+            return true;
+        }
+        if (errno == EINTR)
+            continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+bool setNonBlocking(int fd)
+{
+    int flags{ ::fcntl(fd, F_GETFL, 0) };
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+volatile std::sig_atomic_t g_stop{ 0 };
+
+extern "C" void requestStop(int)
+{
+    g_stop = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path{ argc > 1 ? argv[1] : defaultAddSocket };
+
+    sockaddr_un address{};
+    socklen_t addressLength{};
+    if (!makeSocketAddress(path, address, addressLength))
+    {
+        std::cerr << "socket path too long: " << path << '\n';
+        return 1;
+    }
+
+    int listener{ ::socket(AF_UNIX, SOCK_STREAM, 0) };
+    ::unlink(path); // a socket file left behind by an earlier run
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr *>(&address), addressLength) != 0 ||
+        ::listen(listener, SOMAXCONN) != 0 || !setNonBlocking(listener))
+    {
+        std::cerr << "can't listen on " << path << ": " << std::strerror(errno) << '\n';
+        return 1;
+    }
+
+    // Ctrl+C interrupts the wait below instead of killing the process, so the socket file gets removed
+    struct sigaction action{};
+    action.sa_handler = requestStop;
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Poller poller;
+    if (!poller.ok())
+    {
+        std::cerr << "can't create the event loop\n";
+        return 1;
+    }
+    poller.add(listener);
+    std::cerr << "add_service listening on " << path << '\n';
+
+    std::unordered_map<int, Connection> connections;
+    std::vector<Event> ready;
+
+    while (!g_stop && poller.wait(ready))
+    {
+        for (const Event &event : ready)
+        {
+            if (event.fd == listener)
+            {
+                int client{};
+                while ((client = ::accept(listener, nullptr, nullptr)) >= 0)
+                {
+                    setNonBlocking(client);
+                    poller.add(client);
+                    connections[client];
+                }
+                continue;
+            }
+
+            auto found{ connections.find(event.fd) };
+            if (found == connections.end())
+                continue;
+            Connection &connection{ found->second };
+
+            bool open{ true };
+            if (event.readable && !connection.peerDone && connection.input.size() < maxInputBytes)
+                open = readInput(event.fd, connection);
+
+            // sending makes room for more replies, and answering for more input: go round until no more gets answered
+            while (true)
+            {
+                if (!connection.output.empty() && !flushOutput(event.fd, connection))
+                {
+                    open = false;
+                    break;
+                }
+                std::size_t unanswered{ connection.input.size() };
+                if (!answerRequests(connection))
+                {
+                    open = false;
+                    break;
+                }
+                if (connection.input.size() == unanswered)
+                    break;
+            }
+
+            // after end of stream only the replies are left: an empty output means every whole request is answered
+            if (connection.peerDone && connection.output.empty())
+                open = false;
+
+            bool reads{ !connection.peerDone && connection.input.size() < maxInputBytes };
+            bool writes{ !connection.output.empty() };
+            if (open && (reads != connection.watchingReads || writes != connection.watchingWrites))
+            {
+                poller.watch(event.fd, reads, writes);
+                connection.watchingReads = reads;
+                connection.watchingWrites = writes;
+            }
+
+            if (!open)
+            {
+                poller.remove(event.fd);
+                ::close(event.fd);
+                connections.erase(found);
+            }
+        }
+    }
+
+    for (auto &[fd, connection] : connections)
+        ::close(fd);
+    ::close(listener);
+    ::unlink(path);
+    std::cerr << "add_service stopped\n";
+    return 0;
+}
+
+#endif
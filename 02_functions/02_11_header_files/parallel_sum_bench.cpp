@@ -0,0 +1,150 @@
+/* Sums big arrays with parallel_reduce and add(), on 1 to N threads.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 -pthread parallel_sum_bench.cpp add.cpp -o parallel_sum_bench
+
+Usage:
+parallel_sum_bench [count] [threads] [grain]
+    sums count ints (default 16777216) and count doubles on pools of 1, 2, ...
+    threads threads (default: the number of cores), grain elements per piece
+    (default 65536), and prints the best of 5 runs against a plain loop.
+    The int pieces are added up with add() and joined with add(); the values
+    are small enough that no sum can overflow, which caps count at 21474836
+    (INT_MAX / 100), and a larger count is refused. Every int sum must equal the
+    loop's, and every double sum, on any number of threads, must equal bit
+    for bit the one from a PoolMode::deterministic pool. */
+
+#include "add.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+// |value| <= maxValue keeps any sum of up to maxCount of them inside an int
+constexpr int maxValue{ 100 };
+constexpr std::size_t maxCount{ std::numeric_limits<int>::max() / maxValue };
+
+template <typename Body>
+double bestMs(Body body)
+{
+    double best{ 0.0 };
+    for (int run{ 0 }; run < 5; ++run)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        body();
+        double ms{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+        if (run == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+int sumInts(WorkStealingPool &pool, const std::vector<int> &values, std::size_t grain)
+{
+    return parallel_reduce(
+        pool, 0, values.size(), grain, 0,
+        [&](std::size_t first, std::size_t last) {
+            int sum{ 0 };
+            for (std::size_t i{ first }; i < last; ++i)
+                sum = add(sum, values[i]);
+            return sum;
+        },
+        add);
+}
+
+double sumDoubles(WorkStealingPool &pool, const std::vector<double> &values, std::size_t grain)
+{
+    // add() only takes ints, so doubles are joined the same way by hand
+    return parallel_reduce(
+        pool, 0, values.size(), grain, 0.0,
+        [&](std::size_t first, std::size_t last) {
+            double sum{ 0.0 };
+            for (std::size_t i{ first }; i < last; ++i)
+                sum += values[i];
+            return sum;
+        },
+        [](double x, double y) { return x + y; });
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{ 1 } << 24 };
+    unsigned maxThreads{ argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                                  : std::max(std::thread::hardware_concurrency(), 1u) };
+    std::size_t grain{ argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 65'536 };
+    if (count > maxCount)
+    {
+        std::cerr << "count can be at most " << maxCount << ", or the int sums could overflow\n";
+        return 1;
+    }
+
+    std::mt19937 rng{ 42 };
+    std::uniform_int_distribution<int> smallInt{ -maxValue, maxValue };
+    std::uniform_real_distribution<double> real{ -1.0, 1.0 };
+    std::vector<int> ints(count);
+    std::vector<double> doubles(count);
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        ints[i] = smallInt(rng);
+        doubles[i] = real(rng);
+    }
+
+    int loopInt{};
+    double loopIntMs{ bestMs([&] {
+        int sum{ 0 };
+        for (int value : ints)
+            sum = add(sum, value);
+        loopInt = sum;
+    }) };
+    double loopDouble{};
+    double loopDoubleMs{ bestMs([&] {
+        double sum{ 0.0 };
+        for (double value : doubles)
+            sum += value;
+        loopDouble = sum;
+    }) };
+
+    WorkStealingPool deterministic{ 1, PoolMode::deterministic };
+    double expectedDouble{ sumDoubles(deterministic, doubles, grain) };
+    bool ok{ sumInts(deterministic, ints, grain) == loopInt &&
+             std::abs(expectedDouble - loopDouble) <= 1e-9 * static_cast<double>(count) };
+
+    std::cout << count << " elements, grain " << grain << "\n"
+              << std::fixed << std::setprecision(2) << "threads   int ms  speedup   double ms  speedup\n"
+              << "   loop " << std::setw(8) << loopIntMs << "           " << std::setw(9) << loopDoubleMs << '\n';
+
+    double oneThreadInt{ 0.0 };
+    double oneThreadDouble{ 0.0 };
+    for (unsigned threads{ 1 }; threads <= maxThreads; ++threads)
+    {
+        WorkStealingPool pool{ threads };
+        int intSum{};
+        double intMs{ bestMs([&] { intSum = sumInts(pool, ints, grain); }) };
+        double doubleSum{};
+        double doubleMs{ bestMs([&] { doubleSum = sumDoubles(pool, doubles, grain); }) };
+        if (threads == 1)
+        {
+            oneThreadInt = intMs;
+            oneThreadDouble = doubleMs;
+        }
+        ok = ok && intSum == loopInt && doubleSum == expectedDouble;
+
+        std::cout << std::setw(7) << threads << ' ' << std::setw(8) << intMs << ' ' << std::setw(7)
+                  << oneThreadInt / intMs << "x  " << std::setw(9) << doubleMs << ' ' << std::setw(7)
+                  << oneThreadDouble / doubleMs << "x\n";
+    }
+
+    if (!ok)
+    {
+        std::cerr << "wrong or unreproducible sums!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,353 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+/* A small fork-join scheduler: parallel_for and parallel_reduce over index
+ranges.
+
+A range is split in halves until the pieces are at most grain indices long.
+At every split the right half becomes a task on the current worker's deque and
+the worker goes on with the left half, so each worker works depth-first
+through its own pieces. An idle worker steals from the top of someone else's
+deque, which holds the oldest and therefore largest pieces. Each worker has a
+Chase-Lev deque: the owner pushes and pops at the bottom without locking, and
+thieves take from the top with one compare-and-swap. Workers that find nothing
+to do spin briefly, then sleep until new tasks are spawned.
+
+The thread that calls parallel_for/parallel_reduce takes part as worker 0, so
+a pool made for N threads starts N - 1 of its own; only one outside thread may
+use a pool at a time. Bodies must not throw.
+
+Reductions are deterministic: the splits depend only on the range and the
+grain, never on the number of threads or on who ran what, so even a
+floating-point sum comes out bit for bit the same every time. For debugging,
+PoolMode::deterministic goes further and runs every task on the calling
+thread, always in the same order. */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/* Chase and Lev's work-stealing deque, with the memory orders from Le, Pop,
+Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory
+Models" (2013). T should be small and trivially copyable, e.g. a pointer. The
+ring grows when full; the old rings are kept until the deque is destroyed,
+since a thief may still be reading one. */
+template <typename T>
+class ChaseLevDeque
+{
+public:
+    explicit ChaseLevDeque(std::int64_t capacity = 64)
+    {
+        m_rings.push_back(std::make_unique<Ring>(capacity));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque &) = delete;
+    ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+    // owner only
+    void push(T item)
+    {
+        std::int64_t bottom{ m_bottom.load(std::memory_order_relaxed) };
+        std::int64_t top{ m_top.load(std::memory_order_acquire) };
+        Ring *ring{ m_ring.load(std::memory_order_relaxed) };
+        if (bottom - top >= ring->capacity)
+            ring = grow(ring, top, bottom);
+
+        // releasing bottom (rather than a release fence, as in the paper) publishes the item to steal's acquire
+        ring->put(bottom, item);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // owner only: the newest item; false if empty (or a thief took the last one)
+    bool pop(T &item)
+    {
+        std::int64_t bottom{ m_bottom.load(std::memory_order_relaxed) - 1 };
+        Ring *ring{ m_ring.load(std::memory_order_relaxed) };
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top{ m_top.load(std::memory_order_relaxed) };
+
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = ring->get(bottom);
+        if (top < bottom)
+            return true;
+
+        // the last item: race any thief for it
+        bool won{ m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed) };
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    // any thread: the oldest item; false if empty or another thread got there first
+    bool steal(T &item)
+    {
+        std::int64_t top{ m_top.load(std::memory_order_acquire) };
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t bottom{ m_bottom.load(std::memory_order_acquire) };
+        if (top >= bottom)
+            return false;
+
+        T stolen{ m_ring.load(std::memory_order_acquire)->get(top) };
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return false;
+        item = stolen;
+        return true;
+    }
+
+private:
+    struct Ring
+    {
+        explicit Ring(std::int64_t size)
+            : capacity{ size },
+              slots{ new std::atomic<T>[static_cast<std::size_t>(size)] }
+        {
+        }
+
+        T get(std::int64_t index) const { return slots[index & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(std::int64_t index, T item) { slots[index & (capacity - 1)].store(item, std::memory_order_relaxed); }
+
+        std::int64_t capacity; // a power of two
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Ring *grow(Ring *ring, std::int64_t top, std::int64_t bottom)
+    {
+        m_rings.push_back(std::make_unique<Ring>(ring->capacity * 2));
+        Ring *bigger{ m_rings.back().get() };
+        for (std::int64_t i{ top }; i < bottom; ++i)
+            bigger->put(i, ring->get(i));
+        m_ring.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // top is written by thieves and bottom by the owner: keep them on separate cache lines
+    alignas(128) std::atomic<std::int64_t> m_top{ 0 };
+    alignas(128) std::atomic<std::int64_t> m_bottom{ 0 };
+    std::atomic<Ring *> m_ring;
+    std::vector<std::unique_ptr<Ring>> m_rings; // owner only
+};
+
+// a piece of work for the pool; whoever spawns it must wait for it before it goes out of scope
+class PoolTask
+{
+public:
+    virtual void execute() = 0;
+
+    std::atomic<bool> finished{ false };
+
+protected:
+    ~PoolTask() = default;
+};
+
+template <typename Body>
+class BodyTask final : public PoolTask
+{
+public:
+    explicit BodyTask(Body &body)
+        : m_body{ body }
+    {
+    }
+
+    void execute() override { m_body(); }
+
+private:
+    Body &m_body;
+};
+
+enum class PoolMode
+{
+    parallel,
+    deterministic, // one thread, tasks always in the same order
+};
+
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency(),
+                              PoolMode mode = PoolMode::parallel)
+        : m_mode{ mode },
+          m_threadCount{ mode == PoolMode::deterministic ? 1u : std::max(threads, 1u) }
+    {
+        for (unsigned i{ 0 }; i < m_threadCount; ++i)
+            m_queues.push_back(std::make_unique<ChaseLevDeque<PoolTask *>>());
+        for (unsigned i{ 1 }; i < m_threadCount; ++i)
+            m_threads.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    ~WorkStealingPool()
+    {
+        m_stop.store(true, std::memory_order_release);
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_all();
+        for (std::thread &thread : m_threads)
+            thread.join();
+    }
+
+    unsigned threadCount() const { return m_threadCount; }
+    PoolMode mode() const { return m_mode; }
+
+    // queues task for whichever worker gets to it first (maybe this one, in wait)
+    void spawn(PoolTask &task)
+    {
+        m_queues[currentWorker()]->push(&task);
+
+        // pairs with the fence in steal: either a sleeper sees the task, or this sees the sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleepers.load(std::memory_order_relaxed) > 0)
+        {
+            m_signal.fetch_add(1, std::memory_order_release);
+            m_signal.notify_one();
+        }
+    }
+
+    // returns once task has run, running other tasks in the meantime
+    void wait(PoolTask &task)
+    {
+        unsigned self{ currentWorker() };
+        while (!task.finished.load(std::memory_order_acquire))
+        {
+            if (!runOne(self))
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    static constexpr unsigned spinsBeforeSleep{ 64 };
+
+    struct CurrentWorker
+    {
+        const WorkStealingPool *pool{ nullptr };
+        unsigned index{ 0 };
+    };
+
+    static CurrentWorker &currentWorkerSlot()
+    {
+        static thread_local CurrentWorker current{};
+        return current;
+    }
+
+    // this thread's worker number; any thread from outside the pool is worker 0
+    unsigned currentWorker() const
+    {
+        const CurrentWorker &current{ currentWorkerSlot() };
+        return current.pool == this ? current.index : 0;
+    }
+
+    // runs one task from this worker's own deque or, failing that, stolen from another
+    bool runOne(unsigned self)
+    {
+        PoolTask *task{ nullptr };
+        bool found{ m_queues[self]->pop(task) };
+
+        // the victims are tried round-robin, starting after a different one every time
+        unsigned start{ m_nextVictim.fetch_add(1, std::memory_order_relaxed) };
+        for (unsigned i{ 0 }; !found && i < m_threadCount; ++i)
+        {
+            unsigned victim{ (start + i) % m_threadCount };
+            if (victim != self)
+                found = m_queues[victim]->steal(task);
+        }
+        if (!found)
+            return false;
+
+        task->execute();
+        task->finished.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void workerLoop(unsigned self)
+    {
+        currentWorkerSlot() = { this, self };
+        unsigned idle{ 0 };
+        while (!m_stop.load(std::memory_order_acquire))
+        {
+            if (runOne(self))
+            {
+                idle = 0;
+                continue;
+            }
+            if (++idle < spinsBeforeSleep)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // announce the sleep, look once more, then sleep until the next spawn
+            unsigned seen{ m_signal.load(std::memory_order_acquire) };
+            m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (!runOne(self) && !m_stop.load(std::memory_order_acquire))
+                m_signal.wait(seen, std::memory_order_acquire);
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            idle = 0;
+        }
+    }
+
+    PoolMode m_mode;
+    unsigned m_threadCount;
+    std::vector<std::unique_ptr<ChaseLevDeque<PoolTask *>>> m_queues; // one per worker
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_stop{ false };
+    std::atomic<unsigned> m_signal{ 0 };   // bumped to wake sleepers
+    std::atomic<unsigned> m_sleepers{ 0 };
+    std::atomic<unsigned> m_nextVictim{ 0 };
+};
+
+// calls body(first, last) for pieces of [begin, end) at most grain long, in parallel
+template <typename Body>
+void parallel_for(WorkStealingPool &pool, std::size_t begin, std::size_t end, std::size_t grain, Body &&body)
+{
+    grain = std::max<std::size_t>(grain, 1);
+    if (end <= begin)
+        return;
+    if (end - begin <= grain)
+    {
+        body(begin, end);
+        return;
+    }
+
+    std::size_t middle{ begin + (end - begin) / 2 };
+    auto rightHalf{ [&] { parallel_for(pool, middle, end, grain, body); } };
+    BodyTask task{ rightHalf };
+    pool.spawn(task);
+    parallel_for(pool, begin, middle, grain, body);
+    pool.wait(task);
+}
+
+/* Reduces [begin, end): map(first, last) reduces one piece at most grain long,
+and combine(left, right) joins the results of neighbouring pieces, in a tree
+that depends only on the range and grain. Returns identity for an empty range. */
+template <typename T, typename Map, typename Combine>
+T parallel_reduce(WorkStealingPool &pool, std::size_t begin, std::size_t end, std::size_t grain, T identity,
+                  Map &&map, Combine &&combine)
+{
+    grain = std::max<std::size_t>(grain, 1);
+    if (end <= begin)
+        return identity;
+    if (end - begin <= grain)
+        return map(begin, end);
+
+    std::size_t middle{ begin + (end - begin) / 2 };
+    T right{ identity };
+    auto rightHalf{ [&] { right = parallel_reduce(pool, middle, end, grain, identity, map, combine); } };
+    BodyTask task{ rightHalf };
+    pool.spawn(task);
+    T left{ parallel_reduce(pool, begin, middle, grain, identity, map, combine) };
+    pool.wait(task);
+    return combine(left, right);
+}
+
+#endif
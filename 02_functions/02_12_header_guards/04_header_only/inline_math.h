@@ -0,0 +1,39 @@
+#ifndef INLINE_MATH_H
+#define INLINE_MATH_H
+
+/* add() from lesson 02.11 and the square functions from 03_solution, defined
+right in the header.
+
+In 03_solution the definitions live in square.cpp (and add() in add.cpp), so
+every call from main.cpp is a call into another code file. The compiler can't
+see the body from there, so it can't inline the call or work out
+getSquarePerimeter(5) while compiling, even though getSquareSides() always
+returns 4.
+
+Plain function definitions in a header break the one-definition rule as soon
+as two code files include it (that's 02_problem). constexpr functions don't:
+they are implicitly inline, and an inline function may be defined in every
+translation unit that uses it as long as all the definitions are identical,
+which one shared header guarantees. The linker keeps a single copy of whatever
+didn't get inlined.
+
+constexpr also lets calls with constant arguments be evaluated at compile time
+(see the static_asserts in main.cpp), and there a signed overflow is a compile
+error instead of undefined behavior. */
+
+constexpr int add(int x, int y)
+{
+    return x + y;
+}
+
+constexpr int getSquareSides()
+{
+    return 4;
+}
+
+constexpr int getSquarePerimeter(int sideLength)
+{
+    return sideLength * getSquareSides();
+}
+
+#endif
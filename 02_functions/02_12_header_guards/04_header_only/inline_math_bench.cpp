@@ -0,0 +1,99 @@
+/* Measures what calling add() and getSquarePerimeter() in another code file
+costs.
+
+The same source is built twice: once against inline_math.h, and once with
+OUT_OF_LINE defined against the out-of-line definitions from 03_solution and
+lesson 02.11 (square.cpp and add.cpp). Build with optimizations, e.g.
+g++ -std=c++20 -O2 inline_math_bench.cpp -o inline_math_bench
+g++ -std=c++20 -O2 -DOUT_OF_LINE inline_math_bench.cpp ../03_solution/square.cpp ../../02_11_header_files/add.cpp -o out_of_line_bench
+
+Usage:
+inline_math_bench [count]   times count calls with a constant argument and
+                            count calls over arrays, best of 20 runs each.
+                            The default, 100000, keeps the arrays in cache,
+                            so the calls are what gets measured. */
+
+#if defined(OUT_OF_LINE)
+#include "../../02_11_header_files/add.h"
+#include "../03_solution/square.h"
+#else
+#include "inline_math.h"
+#endif
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename Body>
+double bestNsPerCall(std::size_t count, Body body)
+{
+    double best{ 0.0 };
+    for (int run{ 0 }; run < 20; ++run)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        body();
+        double ns{ std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+        if (run == 0 || ns < best)
+            best = ns;
+    }
+    return best / static_cast<double>(count);
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000 };
+
+    std::vector<int> sides(count), x(count), y(count), sums(count);
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        sides[i] = static_cast<int>(i % 1000);
+        x[i] = static_cast<int>(i % 4096);
+        y[i] = static_cast<int>(i % 777);
+    }
+
+    // with the definitions in sight, this loop is folded down to one multiplication
+    long long constantTotal{};
+    double constantNs{ bestNsPerCall(count, [&] {
+        long long total{ 0 };
+        for (std::size_t i{ 0 }; i < count; ++i)
+            total += getSquarePerimeter(5);
+        constantTotal = total;
+    }) };
+
+    long long perimeterTotal{};
+    double perimeterNs{ bestNsPerCall(count, [&] {
+        long long total{ 0 };
+        for (std::size_t i{ 0 }; i < count; ++i)
+            total += getSquarePerimeter(sides[i]);
+        perimeterTotal = total;
+    }) };
+
+    double addNs{ bestNsPerCall(count, [&] {
+        for (std::size_t i{ 0 }; i < count; ++i)
+            sums[i] = add(x[i], y[i]);
+    }) };
+
+#if defined(OUT_OF_LINE)
+    std::cout << "out-of-line (square.cpp, add.cpp)\n";
+#else
+    std::cout << "header-only (inline_math.h)\n";
+#endif
+    std::cout << "getSquarePerimeter(5)         " << constantNs << " ns/call\n"
+              << "getSquarePerimeter(sides[i])  " << perimeterNs << " ns/call\n"
+              << "add(x[i], y[i])               " << addNs << " ns/call\n";
+
+    // the same answers either way
+    long long expectedPerimeters{ 0 };
+    bool ok{ constantTotal == 20LL * static_cast<long long>(count) };
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        expectedPerimeters += 4LL * sides[i];
+        ok = ok && sums[i] == x[i] + y[i];
+    }
+    if (!ok || perimeterTotal != expectedPerimeters)
+    {
+        std::cerr << "wrong results!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+/* A third way out of 02_problem: instead of moving the definitions into a .cpp
+file, make them constexpr and keep them in the header (see inline_math.h).
+
+Build both code files together, e.g.
+g++ -std=c++20 main.cpp print_square.cpp -o main */
+
+#include "inline_math.h"
+#include "print_square.h"
+#include <iostream>
+
+// worked out by the compiler; these lines don't produce any code
+static_assert(getSquareSides() == 4);
+static_assert(getSquarePerimeter(5) == 20);
+static_assert(add(3, 4) == 7);
+
+int main()
+{
+    std::cout << "a square has " << getSquareSides() << " sides\n";
+    std::cout << "a square of length 5 has perimeter length " << getSquarePerimeter(5) << '\n';
+    std::cout << "The sum of 3 and 4 is " << add(3, 4) << '\n';
+    printSquare(7);
+
+    return 0;
+}
+
+/* Both main.cpp and print_square.cpp get a copy of every definition in
+inline_math.h, just like in 02_problem. This time the linker doesn't complain:
+constexpr functions are inline, and inline functions are allowed one
+(identical) definition per code file. */
@@ -0,0 +1,448 @@
+#ifndef POLYGONS_H
+#define POLYGONS_H
+
+/* Batch geometry for millions of regular polygons.
+
+getSquarePerimeter() in inline_math.h works on one square at a time. Here a
+RegularPolygons<Sides> holds many polygons with the same (compile-time) number
+of sides, one array per field: all the x positions, then all the y positions,
+then all the side lengths. Measuring perimeters and areas only needs the side
+lengths, so every cache line fetched is full of them, and 8 (AVX2) or 4 (NEON)
+polygons are done per instruction. The path is picked once at runtime, from the
+CPU's features (see cpu_features.h).
+
+selectByArea filters and reduces in the same pass: it finds the polygons whose
+area is in a range and adds up their perimeters and areas without writing the
+areas anywhere. totals() is the same pass with no filter.
+
+Every path computes each polygon's perimeter and area with the same float
+operations, so measure() and the selections don't depend on the path; the
+totals are summed in double, in a path-dependent order. */
+
+#include "inline_math.h"
+#include "../../../cpu_features.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <vector>
+
+// what one pass over a batch of polygons adds up
+struct PolygonTotals
+{
+    std::size_t count{};
+    double perimeter{}; // sum of the perimeters
+    double area{};      // sum of the areas
+    float minArea{ std::numeric_limits<float>::infinity() };
+    float maxArea{ -std::numeric_limits<float>::infinity() };
+};
+
+enum class GeometryPath
+{
+    scalar,
+    avx2,
+    neon,
+};
+
+inline const char *geometryPathName(GeometryPath path)
+{
+    switch (path)
+    {
+    case GeometryPath::avx2: return "avx2";
+    case GeometryPath::neon: return "neon";
+    default:                 return "scalar";
+    }
+}
+
+// the widest path this CPU (and OS) can run
+inline GeometryPath detectGeometryPath()
+{
+    const CpuFeatures &cpu{ cpuFeatures() };
+    if (cpu.avx2)
+        return GeometryPath::avx2;
+    if (cpu.neon)
+        return GeometryPath::neon;
+    return GeometryPath::scalar;
+}
+
+inline GeometryPath g_geometryPath{ detectGeometryPath() };
+
+inline GeometryPath activeGeometryPath()
+{
+    return g_geometryPath;
+}
+
+// forces a narrower path, e.g. to compare paths; unsupported requests fall back to scalar
+inline void forceGeometryPath(GeometryPath path)
+{
+    bool supported{ path == GeometryPath::scalar || path == detectGeometryPath() };
+    g_geometryPath = supported ? path : GeometryPath::scalar;
+}
+
+
+/* Batch kernels, over count side lengths. A polygon's perimeter is
+perimeterFactor * length and its area (areaFactor * length) * length.
+
+selectBatch adds up the polygons whose area is in [minArea, maxArea] and, if
+selected isn't null, writes their indices there (room for count is needed). */
+
+inline void measureBatchScalar(const float *lengths, std::size_t count, float perimeterFactor, float areaFactor,
+                               float *perimeters, float *areas)
+{
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        perimeters[i] = perimeterFactor * lengths[i];
+        areas[i] = areaFactor * lengths[i] * lengths[i];
+    }
+}
+
+inline PolygonTotals selectBatchScalar(const float *lengths, std::size_t count, float perimeterFactor,
+                                       float areaFactor, float minArea, float maxArea, std::uint32_t *selected)
+{
+    PolygonTotals totals{};
+    double lengthSum{ 0.0 };
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        float area{ areaFactor * lengths[i] * lengths[i] };
+        if (area >= minArea && area <= maxArea)
+        {
+            if (selected)
+                selected[totals.count] = static_cast<std::uint32_t>(i);
+            ++totals.count;
+            lengthSum += lengths[i];
+            totals.area += area;
+            totals.minArea = std::min(totals.minArea, area);
+            totals.maxArea = std::max(totals.maxArea, area);
+        }
+    }
+    totals.perimeter = perimeterFactor * lengthSum;
+    return totals;
+}
+
+// folds part (e.g. a kernel's scalar tail) into totals
+inline void mergeTotals(PolygonTotals &totals, const PolygonTotals &part)
+{
+    totals.count += part.count;
+    totals.perimeter += part.perimeter;
+    totals.area += part.area;
+    totals.minArea = std::min(totals.minArea, part.minArea);
+    totals.maxArea = std::max(totals.maxArea, part.maxArea);
+}
+
+
+#if defined(SIMD_X86)
+
+// for every 8-bit lane mask, the numbers of its set lanes, lowest first, packed 3 bits each
+inline constexpr std::array<std::uint32_t, 256> selectedLanes{ []
+{
+    std::array<std::uint32_t, 256> table{};
+    for (unsigned mask{ 0 }; mask < 256; ++mask)
+    {
+        unsigned slot{ 0 };
+        for (unsigned lane{ 0 }; lane < 8; ++lane)
+        {
+            if (mask & (1u << lane))
+                table[mask] |= lane << (3 * slot++);
+        }
+    }
+    return table;
+}() };
+
+SIMD_TARGET("avx2")
+inline void measureBatchAvx2(const float *lengths, std::size_t count, float perimeterFactor, float areaFactor,
+                             float *perimeters, float *areas)
+{
+    __m256 perimeterScale = _mm256_set1_ps(perimeterFactor);
+    __m256 areaScale = _mm256_set1_ps(areaFactor);
+
+    std::size_t i{ 0 };
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 length = _mm256_loadu_ps(lengths + i);
+        _mm256_storeu_ps(perimeters + i, _mm256_mul_ps(perimeterScale, length));
+        _mm256_storeu_ps(areas + i, _mm256_mul_ps(_mm256_mul_ps(areaScale, length), length));
+    }
+    measureBatchScalar(lengths + i, count - i, perimeterFactor, areaFactor, perimeters + i, areas + i);
+}
+
+// 8 polygons per step; the sums are widened to two vectors of 4 doubles
+SIMD_TARGET("avx2")
+inline PolygonTotals selectBatchAvx2(const float *lengths, std::size_t count, float perimeterFactor,
+                                     float areaFactor, float minArea, float maxArea, std::uint32_t *selected)
+{
+    __m256 areaScale = _mm256_set1_ps(areaFactor);
+    __m256 low = _mm256_set1_ps(minArea);
+    __m256 high = _mm256_set1_ps(maxArea);
+    __m256 infinity = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 negativeInfinity = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+
+    __m256d lengthSum = _mm256_setzero_pd();
+    __m256d areaSum = _mm256_setzero_pd();
+    __m256 minimum = infinity;
+    __m256 maximum = negativeInfinity;
+    __m256i laneShifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    __m256i laneMask = _mm256_set1_epi32(7);
+    std::size_t found{ 0 };
+
+    std::size_t i{ 0 };
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 length = _mm256_loadu_ps(lengths + i);
+        __m256 area = _mm256_mul_ps(_mm256_mul_ps(areaScale, length), length);
+        __m256 inRange = _mm256_and_ps(_mm256_cmp_ps(area, low, _CMP_GE_OQ), _mm256_cmp_ps(area, high, _CMP_LE_OQ));
+
+        // polygons outside the range add 0 to the sums and can't be the min or max
+        __m256 keptLength = _mm256_and_ps(inRange, length);
+        __m256 keptArea = _mm256_and_ps(inRange, area);
+        lengthSum = _mm256_add_pd(lengthSum, _mm256_cvtps_pd(_mm256_castps256_ps128(keptLength)));
+        lengthSum = _mm256_add_pd(lengthSum, _mm256_cvtps_pd(_mm256_extractf128_ps(keptLength, 1)));
+        areaSum = _mm256_add_pd(areaSum, _mm256_cvtps_pd(_mm256_castps256_ps128(keptArea)));
+        areaSum = _mm256_add_pd(areaSum, _mm256_cvtps_pd(_mm256_extractf128_ps(keptArea, 1)));
+        minimum = _mm256_min_ps(minimum, _mm256_blendv_ps(infinity, area, inRange));
+        maximum = _mm256_max_ps(maximum, _mm256_blendv_ps(negativeInfinity, area, inRange));
+
+        /* The indices of the selected lanes are unpacked from the table and all 8
+        stored; only the first popcount of them count. The rest land where the next
+        indices go, and never past count, since found <= i. */
+        auto bits{ static_cast<unsigned>(_mm256_movemask_ps(inRange)) };
+        if (selected)
+        {
+            __m256i packed = _mm256_set1_epi32(static_cast<int>(selectedLanes[bits]));
+            __m256i lanes = _mm256_and_si256(_mm256_srlv_epi32(packed, laneShifts), laneMask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(selected + found),
+                                _mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(i))));
+        }
+        found += static_cast<std::size_t>(std::popcount(bits));
+    }
+
+    alignas(32) double lengthSums[4];
+    alignas(32) double areaSums[4];
+    alignas(32) float minimums[8];
+    alignas(32) float maximums[8];
+    _mm256_store_pd(lengthSums, lengthSum);
+    _mm256_store_pd(areaSums, areaSum);
+    _mm256_store_ps(minimums, minimum);
+    _mm256_store_ps(maximums, maximum);
+
+    PolygonTotals totals{};
+    totals.count = found;
+    totals.perimeter = perimeterFactor * (lengthSums[0] + lengthSums[1] + lengthSums[2] + lengthSums[3]);
+    totals.area = areaSums[0] + areaSums[1] + areaSums[2] + areaSums[3];
+    for (int lane{ 0 }; lane < 8; ++lane)
+    {
+        totals.minArea = std::min(totals.minArea, minimums[lane]);
+        totals.maxArea = std::max(totals.maxArea, maximums[lane]);
+    }
+
+    PolygonTotals tail{ selectBatchScalar(lengths + i, count - i, perimeterFactor, areaFactor, minArea, maxArea,
+                                          selected ? selected + found : nullptr) };
+    if (selected)
+    {
+        for (std::size_t t{ 0 }; t < tail.count; ++t)
+            selected[found + t] += static_cast<std::uint32_t>(i);
+    }
+    mergeTotals(totals, tail);
+    return totals;
+}
+
+#endif // SIMD_X86
+
+
+#if defined(SIMD_NEON)
+
+inline void measureBatchNeon(const float *lengths, std::size_t count, float perimeterFactor, float areaFactor,
+                             float *perimeters, float *areas)
+{
+    float32x4_t perimeterScale = vdupq_n_f32(perimeterFactor);
+    float32x4_t areaScale = vdupq_n_f32(areaFactor);
+
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t length = vld1q_f32(lengths + i);
+        vst1q_f32(perimeters + i, vmulq_f32(perimeterScale, length));
+        vst1q_f32(areas + i, vmulq_f32(vmulq_f32(areaScale, length), length));
+    }
+    measureBatchScalar(lengths + i, count - i, perimeterFactor, areaFactor, perimeters + i, areas + i);
+}
+
+// 4 polygons per step; the sums are widened to 2 doubles per half
+inline PolygonTotals selectBatchNeon(const float *lengths, std::size_t count, float perimeterFactor,
+                                     float areaFactor, float minArea, float maxArea, std::uint32_t *selected)
+{
+    float32x4_t areaScale = vdupq_n_f32(areaFactor);
+    float32x4_t low = vdupq_n_f32(minArea);
+    float32x4_t high = vdupq_n_f32(maxArea);
+    float32x4_t infinity = vdupq_n_f32(std::numeric_limits<float>::infinity());
+    float32x4_t negativeInfinity = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+    const std::uint32_t laneBitValues[4]{ 1, 2, 4, 8 };
+    uint32x4_t laneBits = vld1q_u32(laneBitValues);
+
+    float64x2_t lengthSum = vdupq_n_f64(0.0);
+    float64x2_t areaSum = vdupq_n_f64(0.0);
+    float32x4_t minimum = infinity;
+    float32x4_t maximum = negativeInfinity;
+    std::size_t found{ 0 };
+
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t length = vld1q_f32(lengths + i);
+        float32x4_t area = vmulq_f32(vmulq_f32(areaScale, length), length);
+        uint32x4_t inRange = vandq_u32(vcgeq_f32(area, low), vcleq_f32(area, high));
+
+        float32x4_t keptLength = vreinterpretq_f32_u32(vandq_u32(inRange, vreinterpretq_u32_f32(length)));
+        float32x4_t keptArea = vreinterpretq_f32_u32(vandq_u32(inRange, vreinterpretq_u32_f32(area)));
+        lengthSum = vaddq_f64(lengthSum, vcvt_f64_f32(vget_low_f32(keptLength)));
+        lengthSum = vaddq_f64(lengthSum, vcvt_high_f64_f32(keptLength));
+        areaSum = vaddq_f64(areaSum, vcvt_f64_f32(vget_low_f32(keptArea)));
+        areaSum = vaddq_f64(areaSum, vcvt_high_f64_f32(keptArea));
+        minimum = vminq_f32(minimum, vbslq_f32(inRange, area, infinity));
+        maximum = vmaxq_f32(maximum, vbslq_f32(inRange, area, negativeInfinity));
+
+        unsigned bits{ vaddvq_u32(vandq_u32(inRange, laneBits)) };
+        if (selected)
+        {
+            for (; bits; bits &= bits - 1)
+                selected[found++] = static_cast<std::uint32_t>(i + static_cast<unsigned>(std::countr_zero(bits)));
+        }
+        else
+            found += static_cast<std::size_t>(std::popcount(bits));
+    }
+
+    PolygonTotals totals{};
+    totals.count = found;
+    totals.perimeter = perimeterFactor * vaddvq_f64(lengthSum);
+    totals.area = vaddvq_f64(areaSum);
+    totals.minArea = vminvq_f32(minimum);
+    totals.maxArea = vmaxvq_f32(maximum);
+
+    PolygonTotals tail{ selectBatchScalar(lengths + i, count - i, perimeterFactor, areaFactor, minArea, maxArea,
+                                          selected ? selected + found : nullptr) };
+    if (selected)
+    {
+        for (std::size_t t{ 0 }; t < tail.count; ++t)
+            selected[found + t] += static_cast<std::uint32_t>(i);
+    }
+    mergeTotals(totals, tail);
+    return totals;
+}
+
+#endif // SIMD_NEON
+
+
+inline void measureBatch(const float *lengths, std::size_t count, float perimeterFactor, float areaFactor,
+                         float *perimeters, float *areas)
+{
+    switch (activeGeometryPath())
+    {
+#if defined(SIMD_X86)
+    case GeometryPath::avx2: measureBatchAvx2(lengths, count, perimeterFactor, areaFactor, perimeters, areas); break;
+#elif defined(SIMD_NEON)
+    case GeometryPath::neon: measureBatchNeon(lengths, count, perimeterFactor, areaFactor, perimeters, areas); break;
+#endif
+    default:                 measureBatchScalar(lengths, count, perimeterFactor, areaFactor, perimeters, areas); break;
+    }
+}
+
+inline PolygonTotals selectBatch(const float *lengths, std::size_t count, float perimeterFactor, float areaFactor,
+                                 float minArea, float maxArea, std::uint32_t *selected)
+{
+    switch (activeGeometryPath())
+    {
+#if defined(SIMD_X86)
+    case GeometryPath::avx2:
+        return selectBatchAvx2(lengths, count, perimeterFactor, areaFactor, minArea, maxArea, selected);
+#elif defined(SIMD_NEON)
+    case GeometryPath::neon:
+        return selectBatchNeon(lengths, count, perimeterFactor, areaFactor, minArea, maxArea, selected);
+#endif
+    default:
+        return selectBatchScalar(lengths, count, perimeterFactor, areaFactor, minArea, maxArea, selected);
+    }
+}
+
+
+/* Many regular polygons with Sides sides each, stored as a struct of arrays.
+Side lengths should not be negative. Indices are 32-bit, so up to 2^32 - 1
+polygons. */
+template <int Sides>
+    requires(Sides >= 3)
+class RegularPolygons
+{
+public:
+    static constexpr int sides{ Sides };
+
+    static constexpr float perimeterOf(float sideLength) { return static_cast<float>(Sides) * sideLength; }
+
+    // Sides * s^2 / (4 tan(pi / Sides)); exactly 1 for squares
+    static inline const float areaFactor{
+        Sides == 4 ? 1.0f : static_cast<float>(Sides / (4.0 * std::tan(std::numbers::pi / Sides)))
+    };
+
+    static float areaOf(float sideLength) { return areaFactor * sideLength * sideLength; }
+
+    void reserve(std::size_t count)
+    {
+        m_x.reserve(count);
+        m_y.reserve(count);
+        m_sideLength.reserve(count);
+    }
+
+    void add(float x, float y, float sideLength)
+    {
+        m_x.push_back(x);
+        m_y.push_back(y);
+        m_sideLength.push_back(sideLength);
+    }
+
+    std::size_t size() const { return m_sideLength.size(); }
+
+    std::span<const float> xs() const { return m_x; }
+    std::span<const float> ys() const { return m_y; }
+    std::span<const float> sideLengths() const { return m_sideLength; }
+    std::span<float> sideLengths() { return m_sideLength; } // for bulk updates in place
+
+    // every polygon's perimeter and area; false (and nothing written) if the sizes don't match
+    bool measure(std::span<float> perimeters, std::span<float> areas) const
+    {
+        if (perimeters.size() != size() || areas.size() != size())
+            return false;
+        measureBatch(m_sideLength.data(), size(), perimeterOf(1.0f), areaFactor, perimeters.data(), areas.data());
+        return true;
+    }
+
+    PolygonTotals totals() const
+    {
+        return selectBatch(m_sideLength.data(), size(), perimeterOf(1.0f), areaFactor,
+                           -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), nullptr);
+    }
+
+    // replaces indices with those of the polygons whose area is in [minArea, maxArea], and adds those up
+    PolygonTotals selectByArea(float minArea, float maxArea, std::vector<std::uint32_t> &indices) const
+    {
+        indices.resize(size());
+        PolygonTotals totals{ selectBatch(m_sideLength.data(), size(), perimeterOf(1.0f), areaFactor, minArea,
+                                          maxArea, indices.data()) };
+        indices.resize(totals.count);
+        return totals;
+    }
+
+private:
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_sideLength;
+};
+
+using Triangles = RegularPolygons<3>;
+using Squares = RegularPolygons<getSquareSides()>;
+using Hexagons = RegularPolygons<6>;
+
+static_assert(Squares::perimeterOf(5.0f) == getSquarePerimeter(5));
+
+#endif
@@ -0,0 +1,171 @@
+/* Compares RegularPolygons with one struct per polygon.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 polygons_bench.cpp -o polygons_bench
+
+Usage:
+polygons_bench [count]   makes count random squares (default 4000000) and
+                         times measuring them, totalling them and selecting
+                         the ones in an area range, first with a
+                         std::vector<Polygon> and getSquarePerimeter() style
+                         per-polygon code, then with Squares on every path
+                         the CPU supports. Results are checked against the
+                         per-polygon code. */
+
+#include "polygons.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// the usual layout: everything about one polygon together
+struct Polygon
+{
+    float x;
+    float y;
+    float sideLength;
+    int sides;
+};
+
+struct Metrics
+{
+    float perimeter;
+    float area;
+};
+
+template <typename Body>
+double bestNsPerPolygon(std::size_t count, Body body)
+{
+    double best{ 0.0 };
+    for (int run{ 0 }; run < 5; ++run)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        body();
+        double ns{ std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+        if (run == 0 || ns < best)
+            best = ns;
+    }
+    return best / static_cast<double>(count);
+}
+
+void print(const char *name, double ns)
+{
+    std::cout << "  " << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(8) << ns << " ns/polygon\n";
+}
+
+bool closeEnough(double x, double y)
+{
+    return std::abs(x - y) <= 1e-9 * std::max(std::abs(x), std::abs(y));
+}
+
+bool sameTotals(const PolygonTotals &x, const PolygonTotals &y)
+{
+    return x.count == y.count && closeEnough(x.perimeter, y.perimeter) && closeEnough(x.area, y.area) &&
+           x.minArea == y.minArea && x.maxArea == y.maxArea;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4'000'000 };
+    constexpr float minArea{ 100.0f };
+    constexpr float maxArea{ 400.0f };
+
+    std::mt19937 rng{ 42 };
+    std::uniform_real_distribution<float> position{ -1000.0f, 1000.0f };
+    std::uniform_real_distribution<float> length{ 0.0f, 30.0f };
+
+    std::vector<Polygon> polygons;
+    Squares squares;
+    squares.reserve(count);
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        Polygon polygon{ position(rng), position(rng), length(rng), getSquareSides() };
+        polygons.push_back(polygon);
+        squares.add(polygon.x, polygon.y, polygon.sideLength);
+    }
+
+    // per polygon, reading its number of sides like getSquarePerimeter() reads getSquareSides()
+    std::cout << "std::vector<Polygon>, one at a time\n";
+    std::vector<Metrics> metrics(count);
+    print("measure", bestNsPerPolygon(count, [&] {
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            const Polygon &polygon{ polygons[i] };
+            metrics[i] = { polygon.sideLength * static_cast<float>(polygon.sides), Squares::areaOf(polygon.sideLength) };
+        }
+    }));
+
+    auto addUp{ [&](float low, float high, std::vector<std::uint32_t> *indices) {
+        PolygonTotals totals{};
+        double lengthSum{ 0.0 };
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            const Polygon &polygon{ polygons[i] };
+            float area{ Squares::areaOf(polygon.sideLength) };
+            if (area >= low && area <= high)
+            {
+                if (indices)
+                    indices->push_back(static_cast<std::uint32_t>(i));
+                ++totals.count;
+                lengthSum += polygon.sideLength;
+                totals.area += area;
+                totals.minArea = std::min(totals.minArea, area);
+                totals.maxArea = std::max(totals.maxArea, area);
+            }
+        }
+        totals.perimeter = getSquareSides() * lengthSum;
+        return totals;
+    } };
+
+    PolygonTotals expectedTotals{};
+    print("totals", bestNsPerPolygon(count, [&] {
+        expectedTotals = addUp(-INFINITY, INFINITY, nullptr);
+    }));
+
+    std::vector<std::uint32_t> expectedIndices;
+    PolygonTotals expectedSelection{};
+    print("select by area", bestNsPerPolygon(count, [&] {
+        expectedIndices.clear();
+        expectedSelection = addUp(minArea, maxArea, &expectedIndices);
+    }));
+
+    GeometryPath best{ activeGeometryPath() };
+    bool ok{ true };
+    for (GeometryPath path : { GeometryPath::scalar, GeometryPath::avx2, GeometryPath::neon })
+    {
+        forceGeometryPath(path);
+        if (activeGeometryPath() != path)
+            continue;
+
+        std::cout << "Squares, " << geometryPathName(path) << '\n';
+        std::vector<float> perimeters(count), areas(count);
+        print("measure", bestNsPerPolygon(count, [&] { squares.measure(perimeters, areas); }));
+
+        PolygonTotals totals{};
+        print("totals", bestNsPerPolygon(count, [&] { totals = squares.totals(); }));
+
+        std::vector<std::uint32_t> indices;
+        PolygonTotals selection{};
+        print("select by area", bestNsPerPolygon(count, [&] { selection = squares.selectByArea(minArea, maxArea, indices); }));
+
+        for (std::size_t i{ 0 }; i < count; ++i)
+            ok = ok && perimeters[i] == metrics[i].perimeter && areas[i] == metrics[i].area;
+        ok = ok && sameTotals(totals, expectedTotals) && sameTotals(selection, expectedSelection) &&
+             indices == expectedIndices;
+    }
+    forceGeometryPath(best);
+
+    std::cout << expectedSelection.count << " of " << count << " squares have an area in [" << minArea << ", "
+              << maxArea << "]\n";
+    if (!ok)
+    {
+        std::cerr << "Squares doesn't match the per-polygon results!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,9 @@
+#include "print_square.h"
+#include "inline_math.h" // inline_math.h is included once here too, and it still links
+#include <iostream>
+
+void printSquare(int sideLength)
+{
+    std::cout << "a square of length " << sideLength << " has perimeter length "
+              << getSquarePerimeter(sideLength) << '\n';
+}
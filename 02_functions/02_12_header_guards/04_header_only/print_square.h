@@ -0,0 +1,6 @@
+#ifndef PRINT_SQUARE_H
+#define PRINT_SQUARE_H
+
+void printSquare(int sideLength);
+
+#endif
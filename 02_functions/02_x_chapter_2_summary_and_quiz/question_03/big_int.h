@@ -0,0 +1,438 @@
+#ifndef BIG_INT_H
+#define BIG_INT_H
+
+/* Integers of any size, for sums that don't fit in 64 bits.
+
+A BigInt is a sign and a magnitude made of 64-bit limbs, least significant
+first. Up to inlineLimbs limbs (128 bits) live inside the object, so anything
+in the range of the fixed-width types never allocates; only larger values move
+their limbs to the heap. Addition runs along the limbs with the CPU's
+add-with-carry and subtract-with-borrow instructions.
+
+Decimal text is converted 19 digits at a time, the most that always fit in a
+limb: parsing multiplies by 10^19 and printing divides by it, each with one or
+two multiplies per limb per chunk and no hardware division. */
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BIG_INT_X64 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+class BigInt
+{
+public:
+    static constexpr std::size_t inlineLimbs{ 2 };
+
+    BigInt() = default;
+
+    BigInt(long long value)
+        : m_negative{ value < 0 }
+    {
+        // negated as unsigned, so the most negative value works too
+        auto magnitude{ static_cast<std::uint64_t>(value) };
+        if (value < 0)
+            magnitude = 0 - magnitude;
+        m_inline[0] = magnitude;
+        m_size = magnitude != 0;
+    }
+
+    // the 128-bit two's complement value high:low, e.g. a 64-bit sum and its carries
+    BigInt(long long high, unsigned long long low)
+        : m_negative{ high < 0 }
+    {
+        auto highBits{ static_cast<std::uint64_t>(high) };
+        std::uint64_t lowBits{ low };
+        if (m_negative)
+        {
+            lowBits = ~lowBits + 1;
+            highBits = ~highBits + (lowBits == 0);
+        }
+        m_inline[0] = lowBits;
+        m_inline[1] = highBits;
+        m_size = 2;
+        trim();
+    }
+
+    BigInt(const BigInt &) = default;
+    BigInt &operator=(const BigInt &) = default;
+
+    BigInt(BigInt &&other) noexcept { *this = std::move(other); }
+
+    // the moved-from value is left as 0
+    BigInt &operator=(BigInt &&other) noexcept
+    {
+        if (this != &other)
+        {
+            std::copy(other.m_inline, other.m_inline + inlineLimbs, m_inline);
+            m_heap = std::move(other.m_heap);
+            m_size = other.m_size;
+            m_negative = other.m_negative;
+
+            other.m_heap.clear();
+            other.m_size = 0;
+            other.m_negative = false;
+        }
+        return *this;
+    }
+
+    /* Parses exactly [first, last): an optional sign and at least one digit. value
+    is only written when that works. */
+    static bool parse(const char *first, const char *last, BigInt &value)
+    {
+        bool negative{ first != last && *first == '-' };
+        if (first != last && (*first == '-' || *first == '+'))
+            ++first;
+        if (first == last)
+            return false;
+
+        // the first chunk takes the odd digits, so every later one has 19
+        BigInt result{};
+        auto digits{ static_cast<std::size_t>(last - first) };
+        std::size_t chunk{ digits % 19 ? digits % 19 : 19 };
+        while (first != last)
+        {
+            std::uint64_t part{ 0 };
+            for (const char *end{ first + chunk }; first != end; ++first)
+            {
+                auto digit{ static_cast<unsigned>(*first - '0') };
+                if (digit > 9)
+                    return false;
+                part = part * 10 + digit;
+            }
+            result.multiplyAdd(powersOf10[chunk], part);
+            chunk = 19;
+        }
+
+        result.m_negative = negative;
+        result.trim();
+        value = std::move(result);
+        return true;
+    }
+
+    bool isNegative() const { return m_negative; }
+
+    // true while the limbs fit inside the object, i.e. nothing has been allocated
+    bool isInline() const { return m_heap.empty(); }
+
+    BigInt &operator+=(const BigInt &other)
+    {
+        if (m_negative == other.m_negative)
+            addMagnitude(other);
+        else if (compareMagnitude(other) >= 0)
+            subtractMagnitude(other);
+        else
+            subtractFromMagnitude(other);
+        return *this;
+    }
+
+    friend BigInt operator+(BigInt x, const BigInt &y)
+    {
+        x += y;
+        return x;
+    }
+
+    BigInt operator-() const
+    {
+        BigInt negated{ *this };
+        negated.m_negative = !m_negative && m_size != 0;
+        return negated;
+    }
+
+    friend bool operator==(const BigInt &x, const BigInt &y)
+    {
+        return x.m_negative == y.m_negative && x.m_size == y.m_size &&
+               std::equal(x.limbs(), x.limbs() + x.m_size, y.limbs());
+    }
+
+    // the most characters toChars can write
+    std::size_t maxDecimalLength() const { return m_size * 20 + 1; }
+
+    // writes the value in decimal from first on, returns the end; needs maxDecimalLength() bytes
+    char *toChars(char *first) const
+    {
+        char *end{ first + maxDecimalLength() };
+        if (m_negative)
+            *first++ = '-';
+        if (m_size <= 1)
+            return std::to_chars(first, end, m_size ? limbs()[0] : 0).ptr;
+
+        // the limbs are divided in place, so work on a copy (on the stack when it fits)
+        std::uint64_t small[inlineLimbs]{};
+        std::vector<std::uint64_t> large;
+        std::uint64_t *work{ small };
+        if (m_size > inlineLimbs)
+        {
+            large.assign(limbs(), limbs() + m_size);
+            work = large.data();
+        }
+        else
+            std::copy(limbs(), limbs() + m_size, small);
+
+        // the digits come out last first, so they're written backwards from the end
+        char *pos{ end };
+        std::size_t size{ m_size };
+        while (size)
+        {
+            std::uint64_t chunk{ divideBy1e19(work, size) };
+            while (size && work[size - 1] == 0)
+                --size;
+
+            // every chunk but the leading one has exactly 19 digits, with zeros in front
+            for (int digit{ 0 }; digit < 19 && (size || chunk); ++digit)
+            {
+                *--pos = static_cast<char>('0' + chunk % 10);
+                chunk /= 10;
+            }
+        }
+
+        auto length{ static_cast<std::size_t>(end - pos) };
+        std::memmove(first, pos, length);
+        return first + length;
+    }
+
+    std::string toString() const
+    {
+        std::string text(maxDecimalLength(), '\0');
+        text.resize(static_cast<std::size_t>(toChars(text.data()) - text.data()));
+        return text;
+    }
+
+private:
+    static constexpr std::array<std::uint64_t, 20> powersOf10{ []
+    {
+        std::array<std::uint64_t, 20> powers{};
+        powers[0] = 1;
+        for (std::size_t i{ 1 }; i < powers.size(); ++i)
+            powers[i] = powers[i - 1] * 10;
+        return powers;
+    }() };
+
+    static unsigned char addWithCarry(unsigned char carry, std::uint64_t x, std::uint64_t y, std::uint64_t &sum)
+    {
+#if defined(BIG_INT_X64)
+        unsigned long long result{};
+        carry = _addcarry_u64(carry, x, y, &result);
+        sum = result;
+        return carry;
+#elif defined(__clang__)
+        unsigned long long carryOut{};
+        sum = __builtin_addcll(x, y, carry, &carryOut);
+        return static_cast<unsigned char>(carryOut);
+#else
+        std::uint64_t partial{ x + y };
+        sum = partial + carry;
+        return static_cast<unsigned char>((partial < x) | (sum < partial));
+#endif
+    }
+
+    static unsigned char subtractWithBorrow(unsigned char borrow, std::uint64_t x, std::uint64_t y,
+                                            std::uint64_t &difference)
+    {
+#if defined(BIG_INT_X64)
+        unsigned long long result{};
+        borrow = _subborrow_u64(borrow, x, y, &result);
+        difference = result;
+        return borrow;
+#elif defined(__clang__)
+        unsigned long long borrowOut{};
+        difference = __builtin_subcll(x, y, borrow, &borrowOut);
+        return static_cast<unsigned char>(borrowOut);
+#else
+        std::uint64_t partial{ x - y };
+        difference = partial - borrow;
+        return static_cast<unsigned char>((x < y) | (partial < borrow));
+#endif
+    }
+
+    // the low half of x * y, with the high half in high
+    static std::uint64_t multiplyWide(std::uint64_t x, std::uint64_t y, std::uint64_t &high)
+    {
+#if defined(__SIZEOF_INT128__)
+        // __extension__ tells -Wpedantic that leaving ISO C++ here is deliberate
+        __extension__ typedef unsigned __int128 Product;
+        Product product{ static_cast<Product>(x) * y };
+        high = static_cast<std::uint64_t>(product >> 64);
+        return static_cast<std::uint64_t>(product);
+#elif defined(_MSC_VER) && defined(BIG_INT_X64)
+        unsigned long long highBits{};
+        std::uint64_t low{ _umul128(x, y, &highBits) };
+        high = highBits;
+        return low;
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+        high = __umulh(x, y);
+        return x * y;
+#else
+        // schoolbook on 32-bit halves
+        std::uint64_t xLow{ x & 0xFFFF'FFFF }, xHigh{ x >> 32 };
+        std::uint64_t yLow{ y & 0xFFFF'FFFF }, yHigh{ y >> 32 };
+        std::uint64_t lowLow{ xLow * yLow };
+        std::uint64_t highLow{ xHigh * yLow };
+        std::uint64_t lowHigh{ xLow * yHigh };
+        std::uint64_t middle{ (lowLow >> 32) + (highLow & 0xFFFF'FFFF) + (lowHigh & 0xFFFF'FFFF) };
+        high = xHigh * yHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32);
+        return x * y;
+#endif
+    }
+
+    /* Divides limbs[0, size) by 10^19 in place and returns the remainder. 10^19
+    has its top bit set, so each step is a 2-by-1 division with a precomputed
+    reciprocal (Moller and Granlund): two multiplies instead of a divide. */
+    static std::uint64_t divideBy1e19(std::uint64_t *limbs, std::size_t size)
+    {
+        constexpr std::uint64_t divisor{ 10'000'000'000'000'000'000u };
+        constexpr std::uint64_t reciprocal{ 0xD83C'94FB'6D2A'C34A }; // (2^128 - 1) / divisor - 2^64
+
+        std::uint64_t remainder{ 0 };
+        for (std::size_t i{ size }; i-- > 0;)
+        {
+            // remainder:limbs[i] / divisor, where remainder < divisor
+            std::uint64_t quotient{};
+            std::uint64_t quotientLow{ multiplyWide(reciprocal, remainder, quotient) };
+            std::uint64_t carry{ addWithCarry(0, quotientLow, limbs[i], quotientLow) };
+            quotient += remainder + 1 + carry;
+
+            std::uint64_t rest{ limbs[i] - quotient * divisor };
+            if (rest > quotientLow)
+            {
+                --quotient;
+                rest += divisor;
+            }
+            if (rest >= divisor)
+            {
+                ++quotient;
+                rest -= divisor;
+            }
+            limbs[i] = quotient;
+            remainder = rest;
+        }
+        return remainder;
+    }
+
+    const std::uint64_t *limbs() const { return m_heap.empty() ? m_inline : m_heap.data(); }
+    std::uint64_t *limbs() { return m_heap.empty() ? m_inline : m_heap.data(); }
+
+    // sets the number of limbs in use; new ones start at 0
+    void resize(std::size_t size)
+    {
+        std::size_t capacity{ m_heap.empty() ? inlineLimbs : m_heap.size() };
+        if (size > capacity)
+        {
+            if (m_heap.empty())
+                m_heap.assign(m_inline, m_inline + m_size);
+            m_heap.resize(std::max(size, capacity * 2));
+        }
+        if (size > m_size)
+            std::fill(limbs() + m_size, limbs() + size, 0);
+        m_size = size;
+    }
+
+    // drops leading zero limbs; zero is never negative
+    void trim()
+    {
+        while (m_size && limbs()[m_size - 1] == 0)
+            --m_size;
+        if (m_size == 0)
+            m_negative = false;
+    }
+
+    int compareMagnitude(const BigInt &other) const
+    {
+        if (m_size != other.m_size)
+            return m_size < other.m_size ? -1 : 1;
+        for (std::size_t i{ m_size }; i-- > 0;)
+        {
+            if (limbs()[i] != other.limbs()[i])
+                return limbs()[i] < other.limbs()[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // |this| += |other|
+    void addMagnitude(const BigInt &other)
+    {
+        std::size_t otherSize{ other.m_size }; // before resize, in case other is *this
+        std::size_t size{ std::max(m_size, otherSize) };
+        resize(size);
+
+        std::uint64_t *x{ limbs() };
+        const std::uint64_t *y{ other.limbs() };
+        unsigned char carry{ 0 };
+        std::size_t i{ 0 };
+        for (; i < otherSize; ++i)
+            carry = addWithCarry(carry, x[i], y[i], x[i]);
+        for (; carry && i < size; ++i)
+            carry = addWithCarry(carry, x[i], 0, x[i]);
+
+        // only a carry out of the top limb needs another one
+        if (carry)
+        {
+            resize(size + 1);
+            limbs()[size] = 1;
+        }
+    }
+
+    // |this| -= |other|, for |this| >= |other|
+    void subtractMagnitude(const BigInt &other)
+    {
+        std::uint64_t *x{ limbs() };
+        const std::uint64_t *y{ other.limbs() };
+        unsigned char borrow{ 0 };
+        std::size_t i{ 0 };
+        for (; i < other.m_size; ++i)
+            borrow = subtractWithBorrow(borrow, x[i], y[i], x[i]);
+        for (; borrow && i < m_size; ++i)
+            borrow = subtractWithBorrow(borrow, x[i], 0, x[i]);
+        trim();
+    }
+
+    // this = other - this in magnitude, taking other's sign, for |this| < |other|
+    void subtractFromMagnitude(const BigInt &other)
+    {
+        resize(other.m_size);
+        std::uint64_t *x{ limbs() };
+        const std::uint64_t *y{ other.limbs() };
+        unsigned char borrow{ 0 };
+        for (std::size_t i{ 0 }; i < other.m_size; ++i)
+            borrow = subtractWithBorrow(borrow, y[i], x[i], x[i]);
+        m_negative = other.m_negative;
+        trim();
+    }
+
+    // |this| = |this| * factor + addend
+    void multiplyAdd(std::uint64_t factor, std::uint64_t addend)
+    {
+        std::uint64_t carry{ addend };
+        std::uint64_t *x{ limbs() };
+        for (std::size_t i{ 0 }; i < m_size; ++i)
+        {
+            std::uint64_t high{};
+            std::uint64_t low{ multiplyWide(x[i], factor, high) };
+            carry = high + addWithCarry(0, low, carry, x[i]);
+        }
+        if (carry)
+        {
+            resize(m_size + 1);
+            limbs()[m_size - 1] = carry;
+        }
+    }
+
+    std::uint64_t m_inline[inlineLimbs]{};
+    std::vector<std::uint64_t> m_heap; // holds the limbs instead of m_inline once they don't fit
+    std::size_t m_size{ 0 };            // limbs in use; the top one is never 0
+    bool m_negative{ false };
+};
+
+#endif
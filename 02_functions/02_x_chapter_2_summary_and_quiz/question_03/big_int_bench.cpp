@@ -0,0 +1,253 @@
+/* Compares BigInt with a textbook big integer.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 big_int_bench.cpp -o big_int_bench
+
+Usage:
+big_int_bench [digits]   times additions of values that fit in 64 bits, of
+                         values just past them, and of digits-digit values
+                         (default 1000), plus parsing and printing those.
+                         Every result is checked against the reference.
+
+The reference, DecimalInt, is the usual first attempt: base 10^9 limbs in a
+std::vector, so decimal conversion is trivial, carries are handled one limb at
+a time with a compare, and every value is on the heap.
+
+Every pass also reports how many heap allocations it made (see
+allocation_counter.h). */
+
+#include "../../../allocation_counter.h"
+#include "./big_int.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+class DecimalInt
+{
+public:
+    static DecimalInt parse(const std::string &text)
+    {
+        DecimalInt value{};
+        std::size_t start{ text[0] == '-' || text[0] == '+' ? std::size_t{ 1 } : 0 };
+        value.m_negative = text[0] == '-';
+        for (std::size_t end{ text.size() }; end > start; end = end >= start + 9 ? end - 9 : start)
+        {
+            std::size_t first{ end >= start + 9 ? end - 9 : start };
+            value.m_limbs.push_back(static_cast<std::uint32_t>(std::stoul(text.substr(first, end - first))));
+        }
+        value.trim();
+        return value;
+    }
+
+    DecimalInt &operator+=(const DecimalInt &other)
+    {
+        if (m_negative == other.m_negative)
+        {
+            std::uint32_t carry{ 0 };
+            for (std::size_t i{ 0 }; i < std::max(m_limbs.size(), other.m_limbs.size()) || carry; ++i)
+            {
+                if (i == m_limbs.size())
+                    m_limbs.push_back(0);
+                m_limbs[i] += carry + (i < other.m_limbs.size() ? other.m_limbs[i] : 0);
+                carry = m_limbs[i] >= base;
+                if (carry)
+                    m_limbs[i] -= base;
+            }
+            return *this;
+        }
+
+        // different signs: take the smaller magnitude from the larger one
+        const DecimalInt *larger{ this };
+        const DecimalInt *smaller{ &other };
+        if (lessInMagnitude(*this, other))
+            std::swap(larger, smaller);
+
+        DecimalInt result{ *larger };
+        std::uint32_t borrow{ 0 };
+        for (std::size_t i{ 0 }; i < result.m_limbs.size(); ++i)
+        {
+            std::uint32_t subtrahend{ borrow + (i < smaller->m_limbs.size() ? smaller->m_limbs[i] : 0) };
+            borrow = result.m_limbs[i] < subtrahend;
+            result.m_limbs[i] += (borrow ? base : 0) - subtrahend;
+        }
+        result.trim();
+        *this = std::move(result);
+        return *this;
+    }
+
+    std::string toString() const
+    {
+        if (m_limbs.empty())
+            return "0";
+        std::string text{ m_negative ? "-" : "" };
+        text += std::to_string(m_limbs.back());
+        for (std::size_t i{ m_limbs.size() - 1 }; i-- > 0;)
+        {
+            std::string chunk{ std::to_string(m_limbs[i]) };
+            text += std::string(9 - chunk.size(), '0') + chunk;
+        }
+        return text;
+    }
+
+private:
+    static constexpr std::uint32_t base{ 1'000'000'000 };
+
+    static bool lessInMagnitude(const DecimalInt &x, const DecimalInt &y)
+    {
+        if (x.m_limbs.size() != y.m_limbs.size())
+            return x.m_limbs.size() < y.m_limbs.size();
+        for (std::size_t i{ x.m_limbs.size() }; i-- > 0;)
+        {
+            if (x.m_limbs[i] != y.m_limbs[i])
+                return x.m_limbs[i] < y.m_limbs[i];
+        }
+        return false;
+    }
+
+    void trim()
+    {
+        while (!m_limbs.empty() && m_limbs.back() == 0)
+            m_limbs.pop_back();
+        if (m_limbs.empty())
+            m_negative = false;
+    }
+
+    std::vector<std::uint32_t> m_limbs; // least significant first
+    bool m_negative{ false };
+};
+
+BigInt parseBig(const std::string &text)
+{
+    BigInt value{};
+    BigInt::parse(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+template <typename Body>
+void timePass(const char *name, std::size_t operations, Body body)
+{
+    std::size_t allocations{ allocationCount() };
+    auto start{ std::chrono::steady_clock::now() };
+    body();
+    double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+    allocations = allocationCount() - allocations;
+
+    std::cout << name << seconds * 1e9 / static_cast<double>(operations) << " ns/op, "
+              << static_cast<double>(allocations) / static_cast<double>(operations) << " allocations/op\n";
+}
+
+/* Adds every value to a running total with both types, then checks that the
+totals agree. values are decimal strings, parsed before the timing starts. */
+bool benchAdd(const char *title, const std::vector<std::string> &values, std::size_t rounds)
+{
+    std::vector<BigInt> bigValues;
+    std::vector<DecimalInt> decimalValues;
+    for (const std::string &text : values)
+    {
+        bigValues.push_back(parseBig(text));
+        decimalValues.push_back(DecimalInt::parse(text));
+    }
+
+    std::cout << '\n' << title << '\n';
+    std::size_t operations{ values.size() * rounds };
+
+    BigInt bigTotal{};
+    timePass("  BigInt      ", operations, [&] {
+        for (std::size_t r{ 0 }; r < rounds; ++r)
+            for (const BigInt &value : bigValues)
+                bigTotal += value;
+    });
+
+    DecimalInt decimalTotal{};
+    timePass("  DecimalInt  ", operations, [&] {
+        for (std::size_t r{ 0 }; r < rounds; ++r)
+            for (const DecimalInt &value : decimalValues)
+                decimalTotal += value;
+    });
+
+    return bigTotal.toString() == decimalTotal.toString();
+}
+
+// parses and prints every value with both types and checks the round trip
+bool benchText(const std::vector<std::string> &values)
+{
+    std::cout << "\nparse and print " << values.front().size() << "-digit values\n";
+
+    std::vector<BigInt> parsed(values.size());
+    timePass("  BigInt parse      ", values.size(), [&] {
+        for (std::size_t i{ 0 }; i < values.size(); ++i)
+            BigInt::parse(values[i].data(), values[i].data() + values[i].size(), parsed[i]);
+    });
+
+    std::vector<DecimalInt> decimalParsed(values.size());
+    timePass("  DecimalInt parse  ", values.size(), [&] {
+        for (std::size_t i{ 0 }; i < values.size(); ++i)
+            decimalParsed[i] = DecimalInt::parse(values[i]);
+    });
+
+    // printing into one reused buffer, as NumberWriter does
+    std::vector<std::string> printed(values.size());
+    std::string buffer(parsed.front().maxDecimalLength() + 64, '\0');
+    timePass("  BigInt print      ", values.size(), [&] {
+        for (std::size_t i{ 0 }; i < values.size(); ++i)
+        {
+            char *end{ parsed[i].toChars(buffer.data()) };
+            printed[i].assign(buffer.data(), end);
+        }
+    });
+
+    std::vector<std::string> decimalPrinted(values.size());
+    timePass("  DecimalInt print  ", values.size(), [&] {
+        for (std::size_t i{ 0 }; i < values.size(); ++i)
+            decimalPrinted[i] = decimalParsed[i].toString();
+    });
+
+    return printed == values && decimalPrinted == values;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t digits{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000 };
+    if (digits == 0)
+        digits = 1;
+
+    std::mt19937_64 rng{ 42 };
+    auto randomDigits{ [&](std::size_t count) {
+        std::string text{ rng() % 2 ? "-" : "" };
+        text += static_cast<char>('1' + rng() % 9);
+        for (std::size_t i{ 1 }; i < count; ++i)
+            text += static_cast<char>('0' + rng() % 10);
+        return text;
+    } };
+
+    std::vector<std::string> small;
+    for (int i{ 0 }; i < 100'000; ++i)
+        small.push_back(std::to_string(static_cast<std::int64_t>(rng()) / 4));
+
+    std::vector<std::string> medium;
+    for (int i{ 0 }; i < 100'000; ++i)
+        medium.push_back(randomDigits(20 + rng() % 10)); // 65 to 97 bits
+
+    std::vector<std::string> large;
+    for (int i{ 0 }; i < 1000; ++i)
+        large.push_back(randomDigits(digits));
+
+    bool ok{ true };
+    ok = benchAdd("add values that fit in 64 bits", small, 20) && ok;
+    ok = benchAdd("add 20 to 29 digit values", medium, 20) && ok;
+    ok = benchAdd(("add " + std::to_string(digits) + "-digit values").c_str(), large, 20) && ok;
+    ok = benchText(large) && ok;
+
+    if (!ok)
+    {
+        std::cerr << "BigInt and DecimalInt disagree!\n";
+        return 1;
+    }
+    return 0;
+}
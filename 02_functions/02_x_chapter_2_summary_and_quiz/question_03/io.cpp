@@ -1,14 +1,96 @@
+#include "./io.h"
+#include <cstdio>
 #include <iostream>
 
+// every read of stdin goes through this one reader, so nothing is lost in its buffer
+static NumberReader &input()
+{
+    static NumberReader reader{ stdin };
+    return reader;
+}
+
+// what a prompt falls back to once the input has run out
+static void reportEndOfInput()
+{
+    if (input().error())
+        std::cerr << "Can't read the input (" << input().error().message() << "), using 0.\n";
+    else
+        std::cerr << "No more input, using 0.\n";
+}
+
 int readNumber()
 {
-    std::cout << "Enter a number: ";
-    int x;
-    std::cin >> x;
-    return x;
+    while (true)
+    {
+        std::cout << "Enter a number: " << std::flush;
+        int x{};
+        switch (input().read(x))
+        {
+        case ReadStatus::ok:
+            return x;
+        case ReadStatus::malformed:
+            std::cerr << '"' << input().badToken() << "\" is not a number, try again.\n";
+            break;
+        case ReadStatus::outOfRange:
+            std::cerr << input().badToken() << " doesn't fit in an int, try again.\n";
+            break;
+        case ReadStatus::endOfInput:
+            reportEndOfInput();
+            return 0;
+        }
+    }
+}
+
+BigInt readBigNumber()
+{
+    while (true)
+    {
+        std::cout << "Enter a number: " << std::flush;
+        BigInt x{};
+        switch (input().read(x))
+        {
+        case ReadStatus::ok:
+            return x;
+        case ReadStatus::endOfInput:
+            reportEndOfInput();
+            return x;
+        default:
+            std::cerr << '"' << input().badToken() << "\" is not a number, try again.\n";
+            break;
+        }
+    }
+}
+
+ReadResult readNumbers(std::span<int> values)
+{
+    return input().readNumbers(values);
+}
+
+// out's FlushPolicy decides when the answer actually reaches the terminal or file
+void writeAnswer(NumberWriter &out, long long sum)
+{
+    out << "The sum of the two numbers is: " << sum << '\n';
 }
 
-void writeAnswer(int sum)
+void writeAnswer(NumberWriter &out, const BigInt &sum)
 {
-    std::cout << "The sum of the two numbers is: " << sum << std::endl;
+    out << "The sum of the two numbers is: " << sum << '\n';
+}
+
+// sum + wraps * 2^64, as the 128-bit two's complement value whose low half is sum
+static BigInt exactSum(const NumberStats &stats)
+{
+    return { stats.wraps + (stats.sum < 0 ? -1 : 0), static_cast<unsigned long long>(stats.sum) };
+}
+
+void writeAnswer(NumberWriter &out, const NumberStats &stats)
+{
+    out << "count: " << stats.count << '\n';
+    if (stats.overflow)
+        out << "sum: " << exactSum(stats) << " (doesn't fit in 64 bits)\n";
+    else
+        out << "sum: " << stats.sum << '\n';
+
+    if (stats.count)
+        out << "min: " << stats.min << '\n' << "max: " << stats.max << '\n';
 }
\ No newline at end of file
@@ -1,7 +1,17 @@
 #ifndef IO_H
 #define IO_H
 
+#include "./big_int.h"
+#include "./number_reader.h"
+#include "./number_stats.h"
+#include "./number_writer.h"
+#include <span>
+
 int readNumber();
-void writeAnswer(int sum);
+BigInt readBigNumber(); // like readNumber, for integers of any size
+ReadResult readNumbers(std::span<int> values); // bulk version of readNumber, no prompt
+void writeAnswer(NumberWriter &out, long long sum);
+void writeAnswer(NumberWriter &out, const BigInt &sum);
+void writeAnswer(NumberWriter &out, const NumberStats &stats);
 
 #endif
\ No newline at end of file
@@ -8,14 +8,22 @@ If you’re having problems, make sure “io.cpp” is properly added to your pr
 it gets compiled. */
 
 #include "./io.h"
+#include <cstdio>
+#include <iostream>
 
 int main()
 {
     int x = readNumber();
     int y = readNumber();
 
-    int sum = x + y;
-    writeAnswer(sum);
+    NumberWriter out{ stdout, FlushPolicy::everyLine };
+    long long sum{ static_cast<long long>(x) + y }; // two ints can add up to more than an int holds
+    writeAnswer(out, sum);
+    if (!out.ok())
+    {
+        std::cerr << "can't write the answer: " << out.error().message() << '\n';
+        return 1;
+    }
 
     return 0;
 }
\ No newline at end of file
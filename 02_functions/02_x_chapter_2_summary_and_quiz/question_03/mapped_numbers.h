@@ -0,0 +1,80 @@
+#ifndef MAPPED_NUMBERS_H
+#define MAPPED_NUMBERS_H
+
+/* Binary operands, mapped instead of parsed.
+
+MappedNumbers<std::int32_t> (or std::int64_t) maps a file of little-endian
+fixed-width integers through MappedFile and hands them out as a std::span that
+points straight into the mapping, so reading the operands costs no more than
+scanning the memory. On a big-endian machine the values have to be
+byte-swapped, so they are copied into a buffer. Like MappedFile it only takes
+regular files: check MappedFile::canMap first and read anything else as a
+stream. */
+
+#include "../../../mapped_file.h"
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+    requires(std::same_as<T, std::int32_t> || std::same_as<T, std::int64_t>)
+class MappedNumbers
+{
+public:
+    explicit MappedNumbers(const char *path)
+        : m_file{ path }
+    {
+        if (!m_file.ok())
+            return;
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            // mappings are page aligned, and so is anything from operator new
+            if (reinterpret_cast<std::uintptr_t>(m_file.data()) % alignof(T) == 0)
+            {
+                m_data = reinterpret_cast<const T *>(m_file.data());
+                return;
+            }
+        }
+        copyIntoBuffer();
+    }
+
+    MappedNumbers(const MappedNumbers &) = delete;
+    MappedNumbers &operator=(const MappedNumbers &) = delete;
+
+    bool ok() const { return m_file.ok(); }
+
+    // every whole value in the file, valid while this object lives
+    std::span<const T> numbers() const { return { m_data, m_file.size() / sizeof(T) }; }
+
+    // bytes at the end of the file that don't make up a whole value
+    std::size_t trailingBytes() const { return m_file.size() % sizeof(T); }
+
+private:
+    // assembles every value from its little-endian bytes, whatever the machine's byte order
+    void copyIntoBuffer()
+    {
+        m_buffer.resize(m_file.size() / sizeof(T));
+        for (std::size_t i{ 0 }; i < m_buffer.size(); ++i)
+        {
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, m_file.data() + i * sizeof(T), sizeof(T));
+            std::make_unsigned_t<T> value{ 0 };
+            for (std::size_t b{ sizeof(T) }; b-- > 0;)
+                value = static_cast<std::make_unsigned_t<T>>((value << 8) | bytes[b]);
+            m_buffer[i] = static_cast<T>(value);
+        }
+        m_data = m_buffer.data();
+    }
+
+    MappedFile m_file;
+    const T *m_data{ nullptr };
+    std::vector<T> m_buffer; // only used when the values can't be used where they are
+};
+
+#endif
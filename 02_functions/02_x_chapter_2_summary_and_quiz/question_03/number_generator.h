@@ -0,0 +1,394 @@
+#ifndef NUMBER_GENERATOR_H
+#define NUMBER_GENERATOR_H
+
+/* Coroutine front ends for NumberReader.
+
+readNumber() pulls one value and blocks. numbers(file) turns the same input into
+a lazy sequence instead:
+
+    for (int x : numbers(stdin))
+        total += x;
+
+asyncNumbers(file) does the same, but reads the next block on another thread
+while the current one is parsed. When the parser gets ahead of the reads, the
+coroutine suspends with pending() set instead of blocking, so the caller can do
+other work before asking again; a range-for just waits.
+
+Yielding a value stores it in the coroutine's promise, so iterating allocates
+nothing. The coroutine frames themselves come from FramePool, which keeps freed
+frames on a per-thread list and hands them to the next coroutine of the same
+size. Bad tokens are skipped and reported on stderr, like sum_stream does. */
+
+#include "./number_reader.h"
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+class FramePool
+{
+public:
+    static void *allocate(std::size_t size)
+    {
+        for (Frame &frame : cache().frames)
+        {
+            if (frame.memory && frame.size == size)
+                return std::exchange(frame.memory, nullptr);
+        }
+        ++cache().allocations;
+        return ::operator new(size);
+    }
+
+    static void deallocate(void *memory, std::size_t size)
+    {
+        for (Frame &frame : cache().frames)
+        {
+            if (!frame.memory)
+            {
+                frame = { memory, size };
+                return;
+            }
+        }
+        ::operator delete(memory); // the cache is full
+    }
+
+    // how many frames this thread has had to get from the heap
+    static std::size_t allocations() { return cache().allocations; }
+
+private:
+    struct Frame
+    {
+        void *memory{ nullptr };
+        std::size_t size{ 0 };
+    };
+
+    struct Cache
+    {
+        std::array<Frame, 8> frames{};
+        std::size_t allocations{ 0 };
+
+        ~Cache()
+        {
+            for (Frame &frame : frames)
+                ::operator delete(frame.memory);
+        }
+    };
+
+    static Cache &cache()
+    {
+        thread_local Cache instance;
+        return instance;
+    }
+};
+
+// promises derive from this so their frames come from FramePool
+struct PooledFrame
+{
+    static void *operator new(std::size_t size) { return FramePool::allocate(size); }
+    static void operator delete(void *memory, std::size_t size) { FramePool::deallocate(memory, size); }
+};
+
+template <typename T>
+class Generator
+{
+public:
+    struct promise_type : PooledFrame
+    {
+        T value{};
+
+        Generator get_return_object() { return Generator{ Handle::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T next) noexcept
+        {
+            value = next;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class iterator
+    {
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(Handle handle) : m_handle{ handle } {}
+
+        const T &operator*() const { return m_handle.promise().value; }
+        iterator &operator++()
+        {
+            m_handle.resume();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return !m_handle || m_handle.done(); }
+
+    private:
+        Handle m_handle{};
+    };
+
+    explicit Generator(Handle handle) : m_handle{ handle } {}
+    Generator(Generator &&other) noexcept : m_handle{ std::exchange(other.m_handle, {}) } {}
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    Generator &operator=(Generator &&) = delete;
+
+    ~Generator()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    iterator begin()
+    {
+        m_handle.resume(); // run up to the first value
+        return iterator{ m_handle };
+    }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    Handle m_handle;
+};
+
+// every int in file, read through a NumberReader
+inline Generator<int> numbers(std::FILE *file)
+{
+    NumberReader reader{ file };
+    while (true)
+    {
+        int value{};
+        switch (reader.read(value))
+        {
+        case ReadStatus::ok:
+            co_yield value;
+            break;
+        case ReadStatus::endOfInput:
+            if (reader.error())
+                std::cerr << "can't read the input: " << reader.error().message() << '\n';
+            co_return;
+        default:
+            std::cerr << "skipping \"" << reader.badToken() << "\"\n";
+            break;
+        }
+    }
+}
+
+
+/* The async variant. It can't read through NumberReader, which blocks inside
+read(2), so it does its own refills: two 1 MiB buffers, one being parsed while
+std::async fills the other. A read error ends the sequence after the values
+read before it, and is reported on stderr like numbers() does. */
+
+// what one refill brought in; error is set if the read stopped on an error rather than the end of the input
+struct BlockRead
+{
+    std::size_t count{};
+    std::error_code error;
+};
+
+class AsyncNumbers
+{
+public:
+    struct promise_type : PooledFrame
+    {
+        int value{};
+        std::future<BlockRead> *refill{ nullptr }; // set while suspended on a refill
+
+        AsyncNumbers get_return_object() { return AsyncNumbers{ Handle::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(int next) noexcept
+        {
+            value = next;
+            refill = nullptr;
+            return {};
+        }
+        std::suspend_always yield_value(std::future<BlockRead> &pending) noexcept
+        {
+            refill = &pending;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit AsyncNumbers(Handle handle) : m_handle{ handle } {}
+    AsyncNumbers(AsyncNumbers &&other) noexcept : m_handle{ std::exchange(other.m_handle, {}) } {}
+    AsyncNumbers(const AsyncNumbers &) = delete;
+    AsyncNumbers &operator=(const AsyncNumbers &) = delete;
+    AsyncNumbers &operator=(AsyncNumbers &&) = delete;
+
+    ~AsyncNumbers()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    /* Runs to the next value or the next pending refill; false at the end. After
+    true, either pending() is set and the caller should come back later, or
+    value() holds the next number. */
+    bool next()
+    {
+        if (!m_handle.done())
+            m_handle.resume();
+        return !m_handle.done();
+    }
+
+    bool pending() const { return m_handle.promise().refill != nullptr; }
+    int value() const { return m_handle.promise().value; }
+
+    // blocks until the pending refill has arrived
+    void wait() const
+    {
+        if (pending())
+            m_handle.promise().refill->wait();
+    }
+
+    class iterator
+    {
+    public:
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(AsyncNumbers *numbers) : m_numbers{ numbers } { advance(); }
+
+        int operator*() const { return m_numbers->value(); }
+        iterator &operator++()
+        {
+            advance();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return m_done; }
+
+    private:
+        void advance()
+        {
+            while ((m_done = !m_numbers->next()) == false && m_numbers->pending())
+                m_numbers->wait();
+        }
+
+        AsyncNumbers *m_numbers{ nullptr };
+        bool m_done{ true };
+    };
+
+    iterator begin() { return iterator{ this }; }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    Handle m_handle;
+};
+
+// runs on the refill thread, so errno is that thread's own
+inline BlockRead readBlock(std::FILE *file, char *dest, std::size_t size)
+{
+    errno = 0;
+    BlockRead read{ std::fread(dest, 1, size, file), {} };
+    if (read.count < size && std::ferror(file))
+        read.error = std::error_code{ errno ? errno : EIO, std::generic_category() };
+    return read;
+}
+
+inline AsyncNumbers asyncNumbers(std::FILE *file, std::size_t blockSize = 1 << 20)
+{
+    std::vector<char> buffers[2]{ std::vector<char>(blockSize), std::vector<char>(blockSize) };
+    std::future<BlockRead> refill{ std::async(std::launch::async, readBlock, file, buffers[0].data(), blockSize) };
+    std::string carry; // a token cut off by the end of the previous block
+
+    for (int current{ 0 };; current ^= 1)
+    {
+        while (refill.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+            co_yield refill;
+        BlockRead read{ refill.get() };
+        std::size_t count{ read.count };
+        bool finalBlock{ count == 0 || read.error }; // nothing more is coming after this block
+
+        // start reading the next block before parsing this one
+        if (!finalBlock)
+            refill = std::async(std::launch::async, readBlock, file, buffers[current ^ 1].data(), blockSize);
+
+        const char *pos{ buffers[current].data() };
+        const char *end{ pos + count };
+
+        if (!carry.empty())
+        {
+            const char *last{ pos };
+            while (last != end && !isTokenSpace(*last))
+                ++last;
+            carry.append(pos, last);
+            pos = last;
+            if (pos == end && !finalBlock)
+                continue; // the token goes on into the next block
+
+            int value{};
+            if (parseToken(carry.data(), carry.data() + carry.size(), value) == ReadStatus::ok)
+                co_yield value;
+            else
+                std::cerr << "skipping \"" << carry << "\"\n";
+            carry.clear();
+        }
+
+        while (true)
+        {
+            while (pos != end && isTokenSpace(*pos))
+                ++pos;
+            if (pos == end)
+                break;
+
+            // fast path: the token ends inside this block
+            int value{};
+            auto [last, error]{ std::from_chars(pos, end, value) };
+            if (error == std::errc{} && last != end && isTokenSpace(*last))
+            {
+                pos = last;
+                co_yield value;
+                continue;
+            }
+
+            last = pos;
+            while (last != end && !isTokenSpace(*last))
+                ++last;
+            if (last == end && !finalBlock)
+            {
+                carry.assign(pos, last);
+                break;
+            }
+
+            if (parseToken(pos, last, value) == ReadStatus::ok)
+                co_yield value;
+            else
+                std::cerr << "skipping \"" << std::string_view(pos, static_cast<std::size_t>(last - pos)) << "\"\n";
+            pos = last;
+        }
+
+        if (finalBlock)
+        {
+            if (read.error)
+                std::cerr << "can't read the input: " << read.error.message() << '\n';
+            co_return;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,128 @@
+/* Compares the coroutine front ends with plain NumberReader loops.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 -pthread number_generator_bench.cpp -o number_generator_bench
+
+Usage:
+number_generator_bench [count]   writes count random ints (default 10000000) to
+                                 a scratch file and sums them four ways: bulk
+                                 readNumbers, one read() per value, numbers()
+                                 and asyncNumbers(). Each pass runs twice, so
+                                 the second one shows what a warm FramePool
+                                 costs. */
+
+#include "../../../allocation_counter.h"
+#include "./number_generator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+struct Pass
+{
+    long long sum{};
+    std::size_t count{};
+};
+
+template <typename Body>
+Pass run(const char *name, const char *path, Body body)
+{
+    Pass pass{};
+    for (int round{ 0 }; round < 2; ++round)
+    {
+        std::FILE *file{ std::fopen(path, "rb") };
+        if (!file)
+            return pass;
+
+        std::size_t allocations{ allocationCount() };
+        auto start{ std::chrono::steady_clock::now() };
+        pass = body(file);
+        double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+        allocations = allocationCount() - allocations;
+        std::fclose(file);
+
+        std::cout << name << (round ? "(warm) " : "       ") << seconds * 1e9 / pass.count << " ns/int, "
+                  << allocations << " allocations\n";
+    }
+    return pass;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000 };
+    const char *path{ "number_generator_bench.txt" };
+
+    {
+        std::FILE *file{ std::fopen(path, "wb") };
+        if (!file)
+        {
+            std::cerr << "can't write " << path << '\n';
+            return 1;
+        }
+        std::mt19937 rng{ 42 };
+        for (std::size_t i{ 0 }; i < count; ++i)
+            std::fprintf(file, "%d\n", static_cast<int>(rng() % 2'000'000) - 1'000'000);
+        std::fclose(file);
+    }
+
+    Pass bulk{ run("readNumbers   ", path, [](std::FILE *file) {
+        Pass pass{};
+        NumberReader reader{ file };
+        std::vector<int> block(1 << 14);
+        while (true)
+        {
+            ReadResult result{ reader.readNumbers(block) };
+            for (std::size_t i{ 0 }; i < result.count; ++i)
+                pass.sum += block[i];
+            pass.count += result.count;
+            if (result.status == ReadStatus::endOfInput)
+                return pass;
+        }
+    }) };
+
+    Pass single{ run("read          ", path, [](std::FILE *file) {
+        Pass pass{};
+        NumberReader reader{ file };
+        int x{};
+        while (reader.read(x) != ReadStatus::endOfInput)
+        {
+            pass.sum += x;
+            ++pass.count;
+        }
+        return pass;
+    }) };
+
+    Pass generated{ run("numbers       ", path, [](std::FILE *file) {
+        Pass pass{};
+        for (int x : numbers(file))
+        {
+            pass.sum += x;
+            ++pass.count;
+        }
+        return pass;
+    }) };
+
+    Pass async{ run("asyncNumbers  ", path, [](std::FILE *file) {
+        Pass pass{};
+        for (int x : asyncNumbers(file))
+        {
+            pass.sum += x;
+            ++pass.count;
+        }
+        return pass;
+    }) };
+
+    std::remove(path);
+
+    for (const Pass &pass : { single, generated, async })
+    {
+        if (pass.sum != bulk.sum || pass.count != bulk.count)
+        {
+            std::cerr << "results differ!\n";
+            return 1;
+        }
+    }
+    return 0;
+}
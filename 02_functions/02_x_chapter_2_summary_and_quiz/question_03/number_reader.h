@@ -0,0 +1,242 @@
+#ifndef NUMBER_READER_H
+#define NUMBER_READER_H
+
+/* Block-buffered integer reader.
+
+std::cin >> x goes through a sentry and the stream's locale on every call, and
+when the input isn't a number it just fails the stream, leaving nothing that
+says which token was at fault. NumberReader pulls its input from the file
+descriptor in large blocks and parses whitespace-separated tokens with
+std::from_chars, which needs neither. A token that isn't an int is consumed and
+reported through the returned status, with its text in badToken(). A failed
+read(2) ends the input like the end of the file does, and error() then says
+what went wrong.
+
+The reader takes over the descriptor behind the FILE it is given, so don't mix
+it with stdio or iostream reads of the same stream. */
+
+#include "./big_int.h"
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+enum class ReadStatus
+{
+    ok,
+    endOfInput, // no more tokens; error() says whether a read failed
+    malformed,  // the token isn't an integer
+    outOfRange, // the token is an integer, but doesn't fit in an int
+};
+
+// the whitespace that separates tokens, as for std::isspace in the "C" locale
+constexpr bool isTokenSpace(char ch)
+{
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+// parses exactly [first, last) as an int; value is only written when the result is ok
+inline ReadStatus parseToken(const char *first, const char *last, int &value)
+{
+    // from_chars doesn't take a leading '+', but std::cin >> x does
+    const char *digits{ (last - first > 1 && first[0] == '+' && first[1] != '-') ? first + 1 : first };
+
+    int parsed{};
+    auto [end, error]{ std::from_chars(digits, last, parsed) };
+    if (end != last)
+        return ReadStatus::malformed;
+    if (error == std::errc::result_out_of_range)
+        return ReadStatus::outOfRange;
+    if (error != std::errc{})
+        return ReadStatus::malformed;
+
+    value = parsed;
+    return ReadStatus::ok;
+}
+
+// parses exactly [first, last) as an integer of any size
+inline ReadStatus parseToken(const char *first, const char *last, BigInt &value)
+{
+    return BigInt::parse(first, last, value) ? ReadStatus::ok : ReadStatus::malformed;
+}
+
+struct ReadResult
+{
+    std::size_t count{};                 // numbers stored
+    ReadStatus status{ ReadStatus::ok }; // why reading stopped; ok if the span was filled
+};
+
+class NumberReader
+{
+public:
+    explicit NumberReader(std::FILE *file, std::size_t blockSize = 1 << 20)
+        : m_file{ file },
+          m_buffer{ new char[blockSize] },
+          m_capacity{ blockSize },
+          m_pos{ m_buffer.get() },
+          m_end{ m_buffer.get() }
+    {
+    }
+
+    NumberReader(const NumberReader &) = delete;
+    NumberReader &operator=(const NumberReader &) = delete;
+
+    // reads the next token into value; value is only written when the result is ok
+    ReadStatus read(int &value)
+    {
+        if (!skipSpace())
+            return ReadStatus::endOfInput;
+
+        // fast path: the token and the whitespace after it are already buffered
+        int parsed{};
+        auto [end, error]{ std::from_chars(m_pos, m_end, parsed) };
+        if (error == std::errc{} && end != m_end && isTokenSpace(*end))
+        {
+            m_pos = end;
+            value = parsed;
+            return ReadStatus::ok;
+        }
+
+        return readToken(value);
+    }
+
+    // reads the next token as an integer of any size; never outOfRange
+    ReadStatus read(BigInt &value)
+    {
+        if (!skipSpace())
+            return ReadStatus::endOfInput;
+        return readToken(value);
+    }
+
+    /* Fills values from the front. Stops early at the end of the input or at a bad
+    token, which is consumed, so calling again carries on with the token after it. */
+    ReadResult readNumbers(std::span<int> values)
+    {
+        ReadResult result{};
+        while (result.count < values.size())
+        {
+            result.status = read(values[result.count]);
+            if (result.status != ReadStatus::ok)
+                break;
+            ++result.count;
+        }
+        return result;
+    }
+
+    // the text of the last malformed or out-of-range token
+    std::string_view badToken() const { return m_badToken; }
+
+    // why the input ended: the error of the read that failed, or none at a real end of file
+    std::error_code error() const { return m_error; }
+
+private:
+    // false once only whitespace is left
+    bool skipSpace()
+    {
+        while (true)
+        {
+            while (m_pos != m_end && isTokenSpace(*m_pos))
+                ++m_pos;
+            if (m_pos != m_end)
+                return true;
+            if (!refill())
+                return false;
+        }
+    }
+
+    // slow path: make sure the whole token is buffered, then parse exactly that token
+    template <typename T>
+    ReadStatus readToken(T &value)
+    {
+        std::size_t length{ 0 };
+        while (true)
+        {
+            while (m_pos + length != m_end && !isTokenSpace(m_pos[length]))
+                ++length;
+            if (m_pos + length != m_end || !refill())
+                break;
+        }
+
+        const char *first{ m_pos };
+        const char *last{ m_pos + length };
+        m_pos = last;
+
+        ReadStatus status{ parseToken(first, last, value) };
+        if (status != ReadStatus::ok)
+            m_badToken.assign(first, last);
+        return status;
+    }
+
+    /* Moves the unread bytes to the front, growing the buffer if a single token
+    fills it, and reads once more. A read from a terminal or pipe returns whatever
+    is available, so interactive input doesn't wait for a whole block. */
+    bool refill()
+    {
+        if (m_eof)
+            return false;
+
+        std::size_t unread{ static_cast<std::size_t>(m_end - m_pos) };
+        if (unread == m_capacity)
+        {
+            std::unique_ptr<char[]> bigger{ new char[m_capacity * 2] };
+            std::memcpy(bigger.get(), m_pos, unread);
+            m_buffer = std::move(bigger);
+            m_capacity *= 2;
+        }
+        else
+            std::memmove(m_buffer.get(), m_pos, unread);
+        m_pos = m_buffer.get();
+        m_end = m_pos + unread;
+
+        std::size_t count{ readSome(m_buffer.get() + unread, m_capacity - unread) };
+        if (count == 0)
+        {
+            m_eof = true;
+            return false;
+        }
+        m_end += count;
+        return true;
+    }
+
+    std::size_t readSome(char *dest, std::size_t size)
+    {
+        while (true)
+        {
+#ifdef _WIN32
+            int count{ _read(_fileno(m_file), dest, static_cast<unsigned int>(size)) };
+#else
+            auto count{ ::read(fileno(m_file), dest, size) };
+#endif
+            if (count >= 0)
+                return static_cast<std::size_t>(count);
+            if (errno != EINTR)
+            {
+                m_error = std::error_code{ errno, std::generic_category() };
+                return 0; // ends the input, as far as the tokens go
+            }
+        }
+    }
+
+    std::FILE *m_file;
+    std::unique_ptr<char[]> m_buffer;
+    std::size_t m_capacity;
+    const char *m_pos; // next unread byte
+    const char *m_end; // one past the last buffered byte
+    bool m_eof{ false };
+    std::error_code m_error;
+    std::string m_badToken;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/* Compares NumberReader with std::ifstream >> x.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 number_reader_bench.cpp -o number_reader_bench
+
+Usage:
+number_reader_bench [count]   writes count random ints (default 10000000) to a
+                              scratch file, reads them back both ways and
+                              prints the time of each. Try 100000000 for the
+                              full-size run; the file is about 1.1 GB. */
+
+#include "./number_reader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+struct Pass
+{
+    long long sum{};
+    std::size_t count{};
+    double seconds{};
+};
+
+Pass readWithStream(const char *path)
+{
+    auto start{ std::chrono::steady_clock::now() };
+
+    Pass pass{};
+    std::ifstream in{ path };
+    int x{};
+    while (in >> x)
+    {
+        pass.sum += x;
+        ++pass.count;
+    }
+
+    pass.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return pass;
+}
+
+Pass readWithReader(const char *path)
+{
+    auto start{ std::chrono::steady_clock::now() };
+
+    Pass pass{};
+    std::FILE *file{ std::fopen(path, "rb") };
+    if (!file)
+        return pass;
+    {
+        NumberReader reader{ file };
+        std::vector<int> values(1 << 16);
+        while (true)
+        {
+            ReadResult result{ reader.readNumbers(values) };
+            for (std::size_t i{ 0 }; i < result.count; ++i)
+                pass.sum += values[i];
+            pass.count += result.count;
+
+            if (result.status == ReadStatus::endOfInput)
+                break;
+            if (result.status != ReadStatus::ok)
+                std::cerr << "bad token: " << reader.badToken() << '\n';
+        }
+    }
+    std::fclose(file);
+
+    pass.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return pass;
+}
+
+void print(const char *name, const Pass &pass)
+{
+    std::cout << name << pass.count << " ints in " << pass.seconds << " s, "
+              << pass.count / pass.seconds / 1e6 << " M ints/s\n";
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000 };
+    const char *path{ "number_reader_bench.txt" };
+
+    {
+        std::FILE *file{ std::fopen(path, "wb") };
+        if (!file)
+        {
+            std::cerr << "can't write " << path << '\n';
+            return 1;
+        }
+
+        std::mt19937 rng{ 42 };
+        std::uniform_int_distribution<int> digits{ 1, 9 };
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            // a mix of short and long values, positive and negative
+            int limit{ 1 };
+            for (int d{ digits(rng) }; d > 0; --d)
+                limit *= 10;
+            int value{ static_cast<int>(rng() % static_cast<unsigned>(limit)) };
+            std::fprintf(file, (i % 16 == 15) ? "%d\n" : "%d ", (rng() & 1) ? value : -value);
+        }
+        std::fclose(file);
+    }
+
+    Pass stream{ readWithStream(path) };
+    Pass reader{ readWithReader(path) };
+    std::remove(path);
+
+    print("ifstream >> x: ", stream);
+    print("NumberReader:  ", reader);
+    std::cout << "speedup: " << stream.seconds / reader.seconds << "x\n";
+
+    if (stream.sum != reader.sum || stream.count != reader.count)
+    {
+        std::cerr << "results differ!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+#ifndef NUMBER_STATS_H
+#define NUMBER_STATS_H
+
+/* Sum, min, max and count of a stream of ints.
+
+addNumbers folds one block of values into a NumberStats. The block is reduced
+by a SIMD kernel (SSE2 or AVX2 on x86, NEON on ARM64, a plain loop elsewhere)
+that widens every int to 64 bits before adding, so a block's sum is always
+exact. Only the 64-bit running total can overflow; that's checked once per
+block, not once per value, and counted in wraps, so the exact sum can still be
+rebuilt from sum and wraps (see exactSum in io.cpp). The path is picked once at
+runtime from the CPU's features (see cpu_features.h). */
+
+#include "../../../cpu_features.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <span>
+
+struct NumberStats
+{
+    long long sum{};
+    int min{ std::numeric_limits<int>::max() };
+    int max{ std::numeric_limits<int>::min() };
+    std::size_t count{};
+    long long wraps{}; // the exact sum is sum + wraps * 2^64
+    bool overflow{};   // the exact sum doesn't fit in long long, so sum alone is wrong
+};
+
+enum class StatsPath
+{
+    scalar,
+    sse2,
+    avx2,
+    neon,
+};
+
+inline const char *statsPathName(StatsPath path)
+{
+    switch (path)
+    {
+    case StatsPath::sse2: return "sse2";
+    case StatsPath::avx2: return "avx2";
+    case StatsPath::neon: return "neon";
+    default:              return "scalar";
+    }
+}
+
+// the widest path this CPU (and OS) can run
+inline StatsPath detectStatsPath()
+{
+    const CpuFeatures &cpu{ cpuFeatures() };
+    if (cpu.avx2)
+        return StatsPath::avx2;
+    if (cpu.sse2)
+        return StatsPath::sse2;
+    if (cpu.neon)
+        return StatsPath::neon;
+    return StatsPath::scalar;
+}
+
+inline StatsPath g_statsPath{ detectStatsPath() };
+
+inline StatsPath activeStatsPath()
+{
+    return g_statsPath;
+}
+
+// forces a narrower path, e.g. to compare paths; unsupported requests fall back to scalar
+inline void forceStatsPath(StatsPath path)
+{
+    StatsPath best{ detectStatsPath() };
+    bool supported{ path == StatsPath::scalar || path == best ||
+                    (path == StatsPath::sse2 && best == StatsPath::avx2) };
+    g_statsPath = supported ? path : StatsPath::scalar;
+}
+
+
+/* Block kernels. Each reduces count values into a fresh NumberStats; count must
+be at most maxStatsBlock, so that no 64-bit lane can overflow. */
+
+inline constexpr std::size_t maxStatsBlock{ std::size_t{ 1 } << 30 };
+
+inline NumberStats statsBlockScalar(const int *values, std::size_t count)
+{
+    NumberStats stats{};
+    stats.count = count;
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        stats.sum += values[i];
+        stats.min = std::min(stats.min, values[i]);
+        stats.max = std::max(stats.max, values[i]);
+    }
+    return stats;
+}
+
+
+#if defined(SIMD_X86)
+
+// 4 ints per step; SSE2 has neither 32-bit min/max nor sign extension, so both are built by hand
+SIMD_TARGET("sse2")
+inline NumberStats statsBlockSse2(const int *values, std::size_t count)
+{
+    __m128i sum = _mm_setzero_si128();
+    __m128i min = _mm_set1_epi32(std::numeric_limits<int>::max());
+    __m128i max = _mm_set1_epi32(std::numeric_limits<int>::min());
+
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+
+        __m128i sign = _mm_srai_epi32(v, 31);
+        sum = _mm_add_epi64(sum, _mm_add_epi64(_mm_unpacklo_epi32(v, sign), _mm_unpackhi_epi32(v, sign)));
+
+        __m128i less = _mm_cmplt_epi32(v, min);
+        min = _mm_or_si128(_mm_and_si128(less, v), _mm_andnot_si128(less, min));
+        __m128i greater = _mm_cmpgt_epi32(v, max);
+        max = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, max));
+    }
+
+    alignas(16) long long sums[2];
+    alignas(16) int mins[4];
+    alignas(16) int maxes[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(sums), sum);
+    _mm_store_si128(reinterpret_cast<__m128i *>(mins), min);
+    _mm_store_si128(reinterpret_cast<__m128i *>(maxes), max);
+
+    NumberStats stats{ statsBlockScalar(values + i, count - i) };
+    stats.sum += sums[0] + sums[1];
+    for (int lane{ 0 }; lane < 4; ++lane)
+    {
+        stats.min = std::min(stats.min, mins[lane]);
+        stats.max = std::max(stats.max, maxes[lane]);
+    }
+    stats.count = count;
+    return stats;
+}
+
+// 8 ints per step, widened to two vectors of 4 x 64-bit sums
+SIMD_TARGET("avx2")
+inline NumberStats statsBlockAvx2(const int *values, std::size_t count)
+{
+    __m256i sumLow = _mm256_setzero_si256();
+    __m256i sumHigh = _mm256_setzero_si256();
+    __m256i min = _mm256_set1_epi32(std::numeric_limits<int>::max());
+    __m256i max = _mm256_set1_epi32(std::numeric_limits<int>::min());
+
+    std::size_t i{ 0 };
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+        sumLow = _mm256_add_epi64(sumLow, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        sumHigh = _mm256_add_epi64(sumHigh, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+        min = _mm256_min_epi32(min, v);
+        max = _mm256_max_epi32(max, v);
+    }
+
+    alignas(32) long long sums[4];
+    alignas(32) int mins[8];
+    alignas(32) int maxes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(sums), _mm256_add_epi64(sumLow, sumHigh));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(mins), min);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(maxes), max);
+
+    NumberStats stats{ statsBlockScalar(values + i, count - i) };
+    stats.sum += sums[0] + sums[1] + sums[2] + sums[3];
+    for (int lane{ 0 }; lane < 8; ++lane)
+    {
+        stats.min = std::min(stats.min, mins[lane]);
+        stats.max = std::max(stats.max, maxes[lane]);
+    }
+    stats.count = count;
+    return stats;
+}
+
+#endif // SIMD_X86
+
+
+#if defined(SIMD_NEON)
+
+// 4 ints per step; vpadalq widens and adds pairs into 2 x 64-bit sums
+inline NumberStats statsBlockNeon(const int *values, std::size_t count)
+{
+    int64x2_t sum = vdupq_n_s64(0);
+    int32x4_t min = vdupq_n_s32(std::numeric_limits<int>::max());
+    int32x4_t max = vdupq_n_s32(std::numeric_limits<int>::min());
+
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        int32x4_t v = vld1q_s32(values + i);
+        sum = vpadalq_s32(sum, v);
+        min = vminq_s32(min, v);
+        max = vmaxq_s32(max, v);
+    }
+
+    NumberStats stats{ statsBlockScalar(values + i, count - i) };
+    stats.sum += vaddvq_s64(sum);
+    stats.min = std::min(stats.min, static_cast<int>(vminvq_s32(min)));
+    stats.max = std::max(stats.max, static_cast<int>(vmaxvq_s32(max)));
+    stats.count = count;
+    return stats;
+}
+
+#endif // SIMD_NEON
+
+
+inline NumberStats statsBlock(const int *values, std::size_t count)
+{
+    switch (activeStatsPath())
+    {
+#if defined(SIMD_X86)
+    case StatsPath::avx2: return statsBlockAvx2(values, count);
+    case StatsPath::sse2: return statsBlockSse2(values, count);
+#elif defined(SIMD_NEON)
+    case StatsPath::neon: return statsBlockNeon(values, count);
+#endif
+    default:              return statsBlockScalar(values, count);
+    }
+}
+
+// folds part into total; the 64-bit sum wraps around, and wraps counts how often
+inline void mergeStats(NumberStats &total, const NumberStats &part)
+{
+    long long before{ total.sum };
+    total.sum = static_cast<long long>(static_cast<unsigned long long>(total.sum) +
+                                       static_cast<unsigned long long>(part.sum));
+    if (part.sum > 0 && total.sum < before)
+        ++total.wraps;
+    else if (part.sum < 0 && total.sum > before)
+        --total.wraps;
+    total.wraps += part.wraps;
+    total.overflow = total.wraps != 0;
+
+    total.min = std::min(total.min, part.min);
+    total.max = std::max(total.max, part.max);
+    total.count += part.count;
+}
+
+// adds every value to stats
+inline void addNumbers(NumberStats &stats, std::span<const int> values)
+{
+    for (std::size_t first{ 0 }; first < values.size(); first += maxStatsBlock)
+    {
+        std::size_t count{ std::min(maxStatsBlock, values.size() - first) };
+        mergeStats(stats, statsBlock(values.data() + first, count));
+    }
+}
+
+#endif
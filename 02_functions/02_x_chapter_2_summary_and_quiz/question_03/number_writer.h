@@ -0,0 +1,161 @@
+#ifndef NUMBER_WRITER_H
+#define NUMBER_WRITER_H
+
+/* Buffered output for numbers and text.
+
+std::cout << x << std::endl formats through the stream's locale and flushes
+after every line, which is one write(2) per answer. NumberWriter formats
+integers with std::to_chars straight into a large buffer and only hands the
+buffer to the FILE when its FlushPolicy says so. The writer goes through the
+FILE (fwrite + fflush), so anything written with stdio or a synced std::cout
+before a flush still comes out first.
+
+A short fwrite or a failed fflush (a full disk, /dev/full, a closed pipe) is
+remembered: ok() turns false and stays false, and error() says why. Output is
+only known to be complete once flush() has returned with ok() still true. */
+
+#include "./big_int.h"
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+enum class FlushPolicy
+{
+    everyLine, // after every '\n', for interactive output
+    whenFull,  // once the buffer holds threshold bytes
+    atExit,    // only on flush() or destruction; the buffer grows as needed
+};
+
+class NumberWriter
+{
+public:
+    explicit NumberWriter(std::FILE *file, FlushPolicy policy = FlushPolicy::whenFull,
+                          std::size_t threshold = 1 << 20)
+        : m_file{ file },
+          m_policy{ policy },
+          m_threshold{ threshold ? threshold : 1 },
+          m_buffer(m_threshold + maxNumberLength)
+    {
+    }
+
+    NumberWriter(const NumberWriter &) = delete;
+    NumberWriter &operator=(const NumberWriter &) = delete;
+
+    ~NumberWriter() { flush(); }
+
+    NumberWriter &operator<<(std::string_view text)
+    {
+        char *dest{ reserve(text.size()) };
+        std::memcpy(dest, text.data(), text.size());
+        m_used += text.size();
+
+        if (m_policy == FlushPolicy::everyLine && std::memchr(text.data(), '\n', text.size()))
+            flush();
+        return afterWrite();
+    }
+
+    NumberWriter &operator<<(char ch)
+    {
+        *reserve(1) = ch;
+        ++m_used;
+
+        if (m_policy == FlushPolicy::everyLine && ch == '\n')
+            flush();
+        return afterWrite();
+    }
+
+    template <std::integral T>
+        requires(!std::same_as<T, bool>)
+    NumberWriter &operator<<(T value)
+    {
+        char *dest{ reserve(maxNumberLength) };
+        m_used = static_cast<std::size_t>(std::to_chars(dest, dest + maxNumberLength, value).ptr - m_buffer.data());
+        return afterWrite();
+    }
+
+    NumberWriter &operator<<(const BigInt &value)
+    {
+        char *dest{ reserve(value.maxDecimalLength()) };
+        m_used = static_cast<std::size_t>(value.toChars(dest) - m_buffer.data());
+        return afterWrite();
+    }
+
+    // hands everything buffered so far to the FILE and flushes it
+    void flush()
+    {
+        drain();
+        errno = 0;
+        if (std::fflush(m_file) != 0)
+            fail();
+    }
+
+    // false once a write or a flush has failed
+    bool ok() const { return !m_error; }
+    std::error_code error() const { return m_error; }
+
+    // how many times the buffer has gone to the FILE
+    std::size_t flushes() const { return m_flushes; }
+
+private:
+    static constexpr std::size_t maxNumberLength{ 20 }; // "-9223372036854775808"
+
+    // room for size more bytes at the end of the buffer
+    char *reserve(std::size_t size)
+    {
+        if (m_used + size > m_buffer.size())
+        {
+            if (m_policy == FlushPolicy::atExit)
+                m_buffer.resize(std::max(m_buffer.size() * 2, m_used + size));
+            else
+            {
+                drain();
+                if (size > m_buffer.size())
+                    m_buffer.resize(size);
+            }
+        }
+        return m_buffer.data() + m_used;
+    }
+
+    NumberWriter &afterWrite()
+    {
+        if (m_policy != FlushPolicy::atExit && m_used >= m_threshold)
+            drain();
+        return *this;
+    }
+
+    // hands the buffer to the FILE without flushing the FILE itself
+    void drain()
+    {
+        if (m_used == 0)
+            return;
+        errno = 0;
+        if (std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+            fail();
+        m_used = 0;
+        ++m_flushes;
+    }
+
+    // keeps the first error; stdio sets errno for the ones it reports
+    void fail()
+    {
+        if (!m_error)
+            m_error = std::error_code{ errno ? errno : EIO, std::generic_category() };
+    }
+
+    std::FILE *m_file;
+    FlushPolicy m_policy;
+    std::size_t m_threshold;
+    std::vector<char> m_buffer;
+    std::size_t m_used{ 0 };
+    std::size_t m_flushes{ 0 };
+    std::error_code m_error;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/* Compares NumberWriter with std::cout for printing many answers.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 number_writer_bench.cpp -o number_writer_bench
+
+Usage:
+number_writer_bench [count] > file   prints count answers (default 10000000)
+                                     three times over: std::cout with
+                                     std::endl, std::cout with '\n', and
+                                     NumberWriter. Timings go to stderr. */
+
+#include "./number_writer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// the i-th answer printed; i * 7 overflows an int for large counts, so it's worked out in long long and wrapped back into an int on purpose
+int answer(int i, int count)
+{
+    return static_cast<int>(static_cast<long long>(i) * 7 - count);
+}
+
+template <typename Body>
+double timeIt(Body body)
+{
+    auto start{ std::chrono::steady_clock::now() };
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int count{ argc > 1 ? std::atoi(argv[1]) : 10'000'000 };
+
+    double endlSeconds{ timeIt([&] {
+        for (int i{ 0 }; i < count; ++i)
+            std::cout << "The sum of the two numbers is: " << answer(i, count) << std::endl;
+    }) };
+
+    double newlineSeconds{ timeIt([&] {
+        for (int i{ 0 }; i < count; ++i)
+            std::cout << "The sum of the two numbers is: " << answer(i, count) << '\n';
+        std::cout << std::flush;
+    }) };
+
+    std::size_t flushes{};
+    double writerSeconds{ timeIt([&] {
+        NumberWriter out{ stdout };
+        for (int i{ 0 }; i < count; ++i)
+            out << "The sum of the two numbers is: " << answer(i, count) << '\n';
+        out.flush();
+        flushes = out.flushes();
+    }) };
+
+    std::cerr << "std::cout, std::endl: " << endlSeconds << " s, " << count << " flushes\n"
+              << "std::cout, '\\n':      " << newlineSeconds << " s\n"
+              << "NumberWriter:         " << writerSeconds << " s, " << flushes << " flushes\n"
+              << "speedup over endl:    " << endlSeconds / writerSeconds << "x\n";
+    return 0;
+}
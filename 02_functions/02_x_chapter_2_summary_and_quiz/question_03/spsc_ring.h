@@ -0,0 +1,117 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+/* Bounded single-producer/single-consumer queue.
+
+One thread pushes, one other thread pops, and neither ever takes a lock. The
+producer owns the tail index and the consumer the head; each keeps a private
+copy of the other's index and only reloads the shared one when its copy says
+the ring is full (or empty), so in the steady state the two threads don't
+touch each other's cache lines. The indices live on separate 128-byte lines,
+which covers both x86 (64-byte lines fetched in pairs) and Apple's ARM cores.
+
+A full ring makes push() wait, which is the back-pressure that stops a fast
+stage from running away from a slow one; an empty one makes pop() wait. Either
+retries for a short while, in case the other side is about to catch up, and
+then sleeps in std::atomic::wait on the other side's index until it moves, so
+a stage that is stalled for long doesn't burn a core. The producer calls
+close() after its last push; pop() then returns false once everything pushed
+has been popped. Closing sets the top bit of the tail, so a consumer asleep on
+the tail wakes up for it too. */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(std::has_single_bit(Capacity), "Capacity must be a power of two");
+
+public:
+    // producer: moves value in unless the ring is full
+    bool tryPush(T &value)
+    {
+        std::size_t tail{ m_tail.load(std::memory_order_relaxed) }; // never closed while pushing
+        if (tail - m_cachedHead == Capacity)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity)
+                return false;
+        }
+
+        m_slots[tail & (Capacity - 1)] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_tail.notify_one();
+        return true;
+    }
+
+    // producer: waits for room
+    void push(T value)
+    {
+        for (int attempt{ 0 }; !tryPush(value); ++attempt)
+        {
+            // full: m_cachedHead is the head that made it so; sleep until the consumer moves it
+            if (attempt >= spins)
+                m_head.wait(m_cachedHead, std::memory_order_acquire);
+        }
+    }
+
+    // producer: no more pushes will follow
+    void close()
+    {
+        m_tail.fetch_or(closedBit, std::memory_order_release);
+        m_tail.notify_one();
+    }
+
+    // consumer: moves the oldest value out unless the ring is empty
+    bool tryPop(T &value)
+    {
+        std::size_t head{ m_head.load(std::memory_order_relaxed) };
+        if (head == m_cachedTail)
+        {
+            m_tailSeen = m_tail.load(std::memory_order_acquire);
+            m_cachedTail = m_tailSeen & ~closedBit;
+            if (head == m_cachedTail)
+                return false;
+        }
+
+        value = std::move(m_slots[head & (Capacity - 1)]);
+        m_head.store(head + 1, std::memory_order_release);
+        m_head.notify_one();
+        return true;
+    }
+
+    // consumer: waits for a value; false once the ring is closed and drained
+    bool pop(T &value)
+    {
+        for (int attempt{ 0 }; !tryPop(value); ++attempt)
+        {
+            // the tail that was just seen empty says whether the ring is closed, and it is final
+            if (m_tailSeen & closedBit)
+                return false;
+            if (attempt >= spins)
+                m_tail.wait(m_tailSeen, std::memory_order_acquire);
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::size_t cacheLine{ 128 };
+    static constexpr std::size_t closedBit{ std::size_t{ 1 } << (std::numeric_limits<std::size_t>::digits - 1) };
+    static constexpr int spins{ 64 }; // failed tries before sleeping
+
+    alignas(cacheLine) std::atomic<std::size_t> m_head{ 0 }; // next slot to pop, written by the consumer
+    std::size_t m_cachedTail{ 0 };                           // the consumer's copy of m_tail, less closedBit
+    std::size_t m_tailSeen{ 0 };                             // m_tail as the consumer last loaded it
+
+    alignas(cacheLine) std::atomic<std::size_t> m_tail{ 0 }; // next slot to push, plus closedBit once closed
+    std::size_t m_cachedHead{ 0 };                           // the producer's copy of m_head
+
+    alignas(cacheLine) std::array<T, Capacity> m_slots{};
+};
+
+#endif
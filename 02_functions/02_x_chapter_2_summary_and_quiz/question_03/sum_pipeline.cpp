@@ -0,0 +1,189 @@
+/* The quiz program as a three-stage pipeline.
+
+Reads a stream of integers, adds them up in pairs and prints one answer per
+pair, like running main.cpp once for every two numbers. Parsing, adding and
+writing each get their own thread:
+
+    reader --parsed--> adder --summed--> writer (main thread)
+
+The stages hand each other batches of 8K values through SpscRings, and every
+batch goes back to the stage that fills it through a second ring once it has
+been used, so no batch is allocated after startup. Only a few batches exist per
+link, which bounds the memory and holds a fast stage back when the one after
+it falls behind.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 -pthread sum_pipeline.cpp io.cpp -o sum_pipeline
+
+Usage:
+sum_pipeline [file|-]            pipelined (default: stdin)
+sum_pipeline --serial [file|-]   the same work on one thread, for comparison
+
+The time taken goes to stderr. */
+
+#include "./io.h"
+#include "./spsc_ring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+constexpr std::size_t batchSize{ 8 * 1024 }; // even, so pairs never straddle two batches
+constexpr std::size_t batchesPerLink{ 4 };
+
+struct IntBatch
+{
+    std::vector<int> values;
+    std::size_t count{};
+};
+
+struct SumBatch
+{
+    std::vector<long long> sums;
+    std::size_t count{};
+};
+
+template <typename T>
+using Link = SpscRing<T, batchesPerLink>;
+
+// fills batch up to batchSize, skipping bad tokens; false once the input is used up or can't be read
+bool fillBatch(NumberReader &reader, IntBatch &batch)
+{
+    batch.count = 0;
+    while (batch.count < batchSize)
+    {
+        ReadResult result{ reader.readNumbers({ batch.values.data() + batch.count, batchSize - batch.count }) };
+        batch.count += result.count;
+
+        if (result.status == ReadStatus::endOfInput)
+        {
+            if (reader.error())
+                std::cerr << "can't read the input: " << reader.error().message() << '\n';
+            return false;
+        }
+        if (result.status != ReadStatus::ok)
+            std::cerr << "skipping \"" << reader.badToken() << "\"\n";
+    }
+    return true;
+}
+
+// adds up neighbouring pairs; a lone value at the very end has no partner
+void addPairs(const IntBatch &batch, SumBatch &out)
+{
+    out.count = batch.count / 2;
+    for (std::size_t i{ 0 }; i < out.count; ++i)
+        out.sums[i] = static_cast<long long>(batch.values[2 * i]) + batch.values[2 * i + 1];
+
+    if (batch.count % 2)
+        std::cerr << "ignoring " << batch.values[batch.count - 1] << ", which has no partner\n";
+}
+
+void writeSums(NumberWriter &out, const SumBatch &batch)
+{
+    for (std::size_t i{ 0 }; i < batch.count; ++i)
+        writeAnswer(out, batch.sums[i]);
+}
+
+// false if reading the input failed part way
+bool runSerial(std::FILE *in, NumberWriter &out)
+{
+    NumberReader reader{ in };
+    IntBatch numbers{ std::vector<int>(batchSize) };
+    SumBatch sums{ std::vector<long long>(batchSize / 2) };
+
+    bool more{ true };
+    while (more)
+    {
+        more = fillBatch(reader, numbers);
+        addPairs(numbers, sums);
+        writeSums(out, sums);
+    }
+    return !reader.error();
+}
+
+bool runPipelined(std::FILE *in, NumberWriter &out)
+{
+    Link<IntBatch> parsed;
+    Link<IntBatch> freeNumbers;
+    Link<SumBatch> summed;
+    Link<SumBatch> freeSums;
+
+    for (std::size_t i{ 0 }; i < batchesPerLink; ++i)
+    {
+        freeNumbers.push({ std::vector<int>(batchSize) });
+        freeSums.push({ std::vector<long long>(batchSize / 2) });
+    }
+
+    bool readFailed{ false }; // the reader's, until it is joined
+    std::thread reader{ [&] {
+        NumberReader input{ in };
+        bool more{ true };
+        while (more)
+        {
+            IntBatch batch;
+            freeNumbers.pop(batch);
+            more = fillBatch(input, batch);
+            parsed.push(std::move(batch));
+        }
+        readFailed = static_cast<bool>(input.error());
+        parsed.close();
+    } };
+
+    std::thread adder{ [&] {
+        IntBatch numbers;
+        while (parsed.pop(numbers))
+        {
+            SumBatch sums;
+            freeSums.pop(sums);
+            addPairs(numbers, sums);
+            freeNumbers.push(std::move(numbers));
+            summed.push(std::move(sums));
+        }
+        summed.close();
+    } };
+
+    SumBatch sums;
+    while (summed.pop(sums))
+    {
+        writeSums(out, sums);
+        freeSums.push(std::move(sums));
+    }
+
+    reader.join();
+    adder.join();
+    return !readFailed;
+}
+
+int main(int argc, char *argv[])
+{
+    bool serial{ argc > 1 && std::strcmp(argv[1], "--serial") == 0 };
+    const char *path{ argc > 1 + serial ? argv[1 + serial] : "-" };
+
+    std::FILE *in{ std::strcmp(path, "-") == 0 ? stdin : std::fopen(path, "r") };
+    if (!in)
+    {
+        std::cerr << "can't open " << path << '\n';
+        return 1;
+    }
+
+    auto start{ std::chrono::steady_clock::now() };
+    bool ok{};
+    {
+        NumberWriter out{ stdout };
+        ok = serial ? runSerial(in, out) : runPipelined(in, out);
+        out.flush();
+        if (!out.ok())
+        {
+            std::cerr << "can't write the sums: " << out.error().message() << '\n';
+            ok = false;
+        }
+    }
+    double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+    if (in != stdin)
+        std::fclose(in);
+    std::cerr << (serial ? "serial: " : "pipelined: ") << seconds << " s\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/* The quiz program, for any number of numbers.
+
+Instead of reading two numbers and printing their sum, this reads every integer
+in a stream and prints how many there were, their sum (exact, even past 64 bits),
+and the smallest and largest.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 sum_stream.cpp io.cpp -o sum_stream
+
+Usage:
+sum_stream [file|-]            whitespace-separated decimal ints (default: stdin)
+sum_stream --binary [file|-]   raw little-endian 32-bit ints
+
+Text and piped binary input are gathered into blocks of 16K ints (64 KiB, small
+enough to stay in L2) and each block goes to addNumbers in one go. A regular
+binary file is mapped instead, so its ints go to addNumbers without being
+copied; a named pipe or /dev/stdin fed from a pipe can't be mapped, so it is
+read like stdin. */
+
+#include "./io.h"
+#include "./mapped_numbers.h"
+#include <bit>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+constexpr std::size_t blockInts{ 16 * 1024 };
+
+bool sumText(std::FILE *in, NumberStats &stats)
+{
+    NumberReader reader{ in };
+    std::vector<int> block(blockInts);
+
+    while (true)
+    {
+        ReadResult result{ reader.readNumbers(block) };
+        addNumbers(stats, { block.data(), result.count });
+
+        if (result.status == ReadStatus::endOfInput)
+        {
+            if (reader.error())
+                std::cerr << reader.error().message() << '\n';
+            return !reader.error();
+        }
+        if (result.status != ReadStatus::ok)
+            std::cerr << "skipping \"" << reader.badToken() << "\": "
+                      << (result.status == ReadStatus::outOfRange ? "doesn't fit in an int" : "not a number")
+                      << '\n';
+    }
+}
+
+// raw little-endian ints from a pipe
+bool sumBinary(std::FILE *in, NumberStats &stats)
+{
+    std::vector<int> block(blockInts);
+    auto *bytes{ reinterpret_cast<char *>(block.data()) };
+    std::size_t capacity{ block.size() * sizeof(int) };
+
+    // a read can stop in the middle of an int: carry its bytes over to the next block
+    std::size_t carried{ 0 };
+    std::size_t count{};
+    while ((count = std::fread(bytes + carried, 1, capacity - carried, in)) > 0)
+    {
+        std::size_t total{ carried + count };
+        std::size_t whole{ total / sizeof(int) };
+        if constexpr (std::endian::native != std::endian::little)
+        {
+            for (std::size_t i{ 0 }; i < whole; ++i)
+            {
+                auto value{ static_cast<std::uint32_t>(block[i]) };
+                value = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF'0000) | (value << 24);
+                block[i] = static_cast<int>(value);
+            }
+        }
+        addNumbers(stats, { block.data(), whole });
+
+        carried = total % sizeof(int);
+        std::memmove(bytes, bytes + whole * sizeof(int), carried);
+    }
+
+    if (std::ferror(in))
+        return false;
+    if (carried)
+        std::cerr << "ignoring " << carried << " trailing bytes that don't make up a whole int\n";
+    return true;
+}
+
+bool sumMapped(const char *path, NumberStats &stats)
+{
+    MappedNumbers<std::int32_t> input{ path };
+    if (!input.ok())
+        return false;
+
+    static_assert(std::is_same_v<std::int32_t, int>);
+    addNumbers(stats, input.numbers());
+
+    if (input.trailingBytes())
+        std::cerr << "ignoring " << input.trailingBytes() << " trailing bytes that don't make up a whole int\n";
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    bool binary{ argc > 1 && std::strcmp(argv[1], "--binary") == 0 };
+    const char *path{ argc > 1 + binary ? argv[1 + binary] : "-" };
+    bool fromStdin{ std::strcmp(path, "-") == 0 };
+
+    NumberStats stats{};
+    bool ok{};
+    if (binary && !fromStdin && MappedFile::canMap(path))
+    {
+        ok = sumMapped(path, stats);
+    }
+    else
+    {
+        std::FILE *in{ fromStdin ? stdin : std::fopen(path, binary ? "rb" : "r") };
+        if (!in)
+        {
+            std::cerr << "can't open " << path << '\n';
+            return 1;
+        }
+#ifdef _WIN32
+        if (binary)
+            _setmode(_fileno(stdin), _O_BINARY);
+#endif
+
+        ok = binary ? sumBinary(in, stats) : sumText(in, stats);
+        if (in != stdin)
+            std::fclose(in);
+    }
+
+    if (!ok)
+    {
+        std::cerr << "error reading " << path << '\n';
+        return 1;
+    }
+
+    NumberWriter out{ stdout };
+    writeAnswer(out, stats);
+    out.flush();
+    if (!out.ok())
+    {
+        std::cerr << "can't write the answer: " << out.error().message() << '\n';
+        return 1;
+    }
+    return 0;
+}
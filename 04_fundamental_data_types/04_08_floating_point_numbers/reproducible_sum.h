@@ -0,0 +1,401 @@
+#ifndef REPRODUCIBLE_SUM_H
+#define REPRODUCIBLE_SUM_H
+
+/* Sums of doubles that come out bit for bit the same however the array is cut
+up: on any number of threads, in any chunks, merged in any order.
+
+ex7 in main.cpp shows why an ordinary sum can't promise that: every + rounds,
+so (a + b) + c and a + (b + c) can differ in the last bits, and a parallel sum
+groups its additions differently for every thread count.
+
+This uses binned summation (after Demmel and Nguyen, "Fast Reproducible
+Floating-Point Summation", 2013). A first pass finds the largest magnitude M,
+which fixes a grid that does not depend on the order. Each value is then split
+into three pieces: its bits in the top 32-bit bin below M, in the bin below
+that, and in the one below that. (x + C) - C, with C = 1.5 * 2^52 * unit,
+rounds x to a multiple of unit in two additions; the remainder is exact. Every
+piece in a bin is a whole number of that bin's unit, so the pieces are added
+exactly, as doubles within a block and as 64-bit integers after it, and exact
+sums don't care about order. Only the final conversion back to a double
+rounds, and it always rounds the same numbers.
+
+Anything more than 96 bits below M is dropped, so the result is within
+count * M * 2^-96 (plus the final rounding) of the true sum; for sums that
+don't cancel, that's closer than a plain loop gets. After every block the
+bins carry into one another and into a 64-bit count of whole 2^32 top-bin
+units, so no bin can run over however many values are added. If there is an
+Inf or a NaN, the result is the sum of just those, which is Inf, -Inf or NaN
+whatever the order. */
+
+#include "sum_path.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <thread>
+#include <vector>
+
+/* Kernels, over count values.
+
+maxMagnitude* return the largest |value|, or NaN if there is one.
+
+binBlock* split every value * factor into three pieces, rounding to the
+multiples of each bin's unit with (x + rounder) - rounder, and add the pieces
+of bin b to sums[b]. Within a block (at most 2^20 values) those additions are
+exact, so splitting the work over lanes doesn't change the result. */
+
+inline double maxMagnitudeScalar(const double *values, std::size_t count)
+{
+    double largest{ 0.0 };
+    bool nan{ false };
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        double magnitude{ std::abs(values[i]) };
+        largest = magnitude > largest ? magnitude : largest;
+        nan = nan || std::isnan(magnitude);
+    }
+    return nan ? std::numeric_limits<double>::quiet_NaN() : largest;
+}
+
+inline void splitIntoBins(double value, const double *rounder, double &sum0, double &sum1, double &sum2)
+{
+    double piece{ (value + rounder[0]) - rounder[0] };
+    sum0 += piece;
+    value -= piece;
+    piece = (value + rounder[1]) - rounder[1];
+    sum1 += piece;
+    value -= piece;
+    sum2 += (value + rounder[2]) - rounder[2];
+}
+
+inline void binBlockScalar(const double *values, std::size_t count, double factor, const double *rounder,
+                           double *sums)
+{
+    // two values at a time, so the two chains of additions overlap
+    double a0{ 0.0 }, a1{ 0.0 }, a2{ 0.0 };
+    double b0{ 0.0 }, b1{ 0.0 }, b2{ 0.0 };
+    std::size_t i{ 0 };
+    for (; i + 2 <= count; i += 2)
+    {
+        splitIntoBins(values[i] * factor, rounder, a0, a1, a2);
+        splitIntoBins(values[i + 1] * factor, rounder, b0, b1, b2);
+    }
+    if (i < count)
+        splitIntoBins(values[i] * factor, rounder, a0, a1, a2);
+
+    sums[0] += a0 + b0;
+    sums[1] += a1 + b1;
+    sums[2] += a2 + b2;
+}
+
+#if defined(SIMD_X86)
+
+SIMD_TARGET("avx2")
+inline double maxMagnitudeAvx2(const double *values, std::size_t count)
+{
+    __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFF));
+    __m256d largest = _mm256_setzero_pd();
+    __m256d nan = _mm256_setzero_pd();
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d magnitude = _mm256_and_pd(_mm256_loadu_pd(values + i), absMask);
+        largest = _mm256_max_pd(magnitude, largest); // a NaN magnitude keeps largest...
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(magnitude, magnitude, _CMP_UNORD_Q)); // ...and is noted here
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, largest);
+    double result{ std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3])) };
+    double tail{ maxMagnitudeScalar(values + i, count - i) };
+    if (_mm256_movemask_pd(nan) != 0 || std::isnan(tail))
+        return std::numeric_limits<double>::quiet_NaN();
+    return std::max(result, tail);
+}
+
+SIMD_TARGET("avx2")
+inline void splitIntoBinsAvx2(__m256d value, const __m256d *rounder, __m256d &sum0, __m256d &sum1, __m256d &sum2)
+{
+    __m256d piece = _mm256_sub_pd(_mm256_add_pd(value, rounder[0]), rounder[0]);
+    sum0 = _mm256_add_pd(sum0, piece);
+    value = _mm256_sub_pd(value, piece);
+    piece = _mm256_sub_pd(_mm256_add_pd(value, rounder[1]), rounder[1]);
+    sum1 = _mm256_add_pd(sum1, piece);
+    value = _mm256_sub_pd(value, piece);
+    sum2 = _mm256_add_pd(sum2, _mm256_sub_pd(_mm256_add_pd(value, rounder[2]), rounder[2]));
+}
+
+SIMD_TARGET("avx2")
+inline void binBlockAvx2(const double *values, std::size_t count, double factor, const double *rounder,
+                         double *sums)
+{
+    __m256d scale = _mm256_set1_pd(factor);
+    __m256d rounders[3] = { _mm256_set1_pd(rounder[0]), _mm256_set1_pd(rounder[1]), _mm256_set1_pd(rounder[2]) };
+
+    // two vectors at a time, each with its own sums
+    __m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0;
+    __m256d b0 = a0, b1 = a0, b2 = a0;
+    std::size_t i{ 0 };
+    for (; i + 8 <= count; i += 8)
+    {
+        splitIntoBinsAvx2(_mm256_mul_pd(_mm256_loadu_pd(values + i), scale), rounders, a0, a1, a2);
+        splitIntoBinsAvx2(_mm256_mul_pd(_mm256_loadu_pd(values + i + 4), scale), rounders, b0, b1, b2);
+    }
+
+    double lanes[3][4];
+    _mm256_storeu_pd(lanes[0], _mm256_add_pd(a0, b0));
+    _mm256_storeu_pd(lanes[1], _mm256_add_pd(a1, b1));
+    _mm256_storeu_pd(lanes[2], _mm256_add_pd(a2, b2));
+    for (int bin{ 0 }; bin < 3; ++bin)
+        sums[bin] += (lanes[bin][0] + lanes[bin][1]) + (lanes[bin][2] + lanes[bin][3]);
+    binBlockScalar(values + i, count - i, factor, rounder, sums);
+}
+
+#endif // SIMD_X86
+
+#if defined(SIMD_NEON)
+
+inline double maxMagnitudeNeon(const double *values, std::size_t count)
+{
+    // unlike the x86 max, fmax returns NaN if either side is NaN
+    float64x2_t largest = vdupq_n_f64(0.0);
+    std::size_t i{ 0 };
+    for (; i + 2 <= count; i += 2)
+        largest = vmaxq_f64(largest, vabsq_f64(vld1q_f64(values + i)));
+
+    double result{ vmaxvq_f64(largest) };
+    double tail{ maxMagnitudeScalar(values + i, count - i) };
+    if (std::isnan(result) || std::isnan(tail))
+        return std::numeric_limits<double>::quiet_NaN();
+    return std::max(result, tail);
+}
+
+inline void splitIntoBinsNeon(float64x2_t value, const float64x2_t *rounder, float64x2_t &sum0, float64x2_t &sum1,
+                              float64x2_t &sum2)
+{
+    float64x2_t piece = vsubq_f64(vaddq_f64(value, rounder[0]), rounder[0]);
+    sum0 = vaddq_f64(sum0, piece);
+    value = vsubq_f64(value, piece);
+    piece = vsubq_f64(vaddq_f64(value, rounder[1]), rounder[1]);
+    sum1 = vaddq_f64(sum1, piece);
+    value = vsubq_f64(value, piece);
+    sum2 = vaddq_f64(sum2, vsubq_f64(vaddq_f64(value, rounder[2]), rounder[2]));
+}
+
+inline void binBlockNeon(const double *values, std::size_t count, double factor, const double *rounder,
+                         double *sums)
+{
+    float64x2_t rounders[3] = { vdupq_n_f64(rounder[0]), vdupq_n_f64(rounder[1]), vdupq_n_f64(rounder[2]) };
+
+    // two vectors at a time, each with its own sums
+    float64x2_t a0 = vdupq_n_f64(0.0), a1 = a0, a2 = a0;
+    float64x2_t b0 = a0, b1 = a0, b2 = a0;
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        splitIntoBinsNeon(vmulq_n_f64(vld1q_f64(values + i), factor), rounders, a0, a1, a2);
+        splitIntoBinsNeon(vmulq_n_f64(vld1q_f64(values + i + 2), factor), rounders, b0, b1, b2);
+    }
+
+    sums[0] += vaddvq_f64(vaddq_f64(a0, b0));
+    sums[1] += vaddvq_f64(vaddq_f64(a1, b1));
+    sums[2] += vaddvq_f64(vaddq_f64(a2, b2));
+    binBlockScalar(values + i, count - i, factor, rounder, sums);
+}
+
+#endif // SIMD_NEON
+
+// the largest |value|, or NaN if there is one; the same in any order
+inline double maxMagnitude(std::span<const double> values)
+{
+    switch (activeSumPath())
+    {
+#if defined(SIMD_X86)
+    case SumPath::avx2: return maxMagnitudeAvx2(values.data(), values.size());
+#elif defined(SIMD_NEON)
+    case SumPath::neon: return maxMagnitudeNeon(values.data(), values.size());
+#endif
+    default:            return maxMagnitudeScalar(values.data(), values.size());
+    }
+}
+
+inline void binBlock(const double *values, std::size_t count, double factor, const double *rounder, double *sums)
+{
+    switch (activeSumPath())
+    {
+#if defined(SIMD_X86)
+    case SumPath::avx2: binBlockAvx2(values, count, factor, rounder, sums); break;
+#elif defined(SIMD_NEON)
+    case SumPath::neon: binBlockNeon(values, count, factor, rounder, sums); break;
+#endif
+    default:            binBlockScalar(values, count, factor, rounder, sums); break;
+    }
+}
+
+inline double maxMagnitude(double x, double y)
+{
+    return std::isnan(x) || x > y ? x : y;
+}
+
+class ReproducibleSum
+{
+public:
+    static constexpr int bins{ 3 }; // the binBlock kernels split into three
+    static constexpr int binBits{ 32 };
+
+    // largest: maxMagnitude of every value that will be added, across all chunks
+    explicit ReproducibleSum(double largest)
+        : m_special{ !std::isfinite(largest) }
+    {
+        if (m_special || largest == 0.0)
+            return;
+
+        int exponent{};
+        std::frexp(largest, &exponent); // largest < 2^exponent
+
+        // near the top of the range, 1.5 * 2^52 * unit would overflow: work on values * 2^-64
+        if (exponent > 960)
+        {
+            m_scale = -64;
+            exponent += m_scale;
+        }
+
+        // the smallest unit is the smallest subnormal, which holds every double exactly
+        for (int bin{ 0 }; bin < bins; ++bin)
+        {
+            m_unitExponent[bin] = std::max(exponent - binBits * (bin + 1), -1074);
+            m_rounder[bin] = 1.5 * std::ldexp(1.0, m_unitExponent[bin] + 52);
+        }
+    }
+
+    // all of values, in any chunks and any order
+    void add(std::span<const double> values)
+    {
+        if (m_special)
+        {
+            for (double value : values)
+            {
+                if (!std::isfinite(value))
+                    m_specialSum += value;
+            }
+            return;
+        }
+        if (m_rounder[0] == 0.0)
+            return; // every value is zero
+
+        for (std::size_t first{ 0 }; first < values.size(); first += blockSize)
+            addBlock(values.subspan(first, std::min(blockSize, values.size() - first)));
+    }
+
+    // adds what other has summed; both must have been made with the same largest
+    void merge(const ReproducibleSum &other)
+    {
+        for (int bin{ 0 }; bin < bins; ++bin)
+            m_bins[bin] += other.m_bins[bin];
+        m_carry += other.m_carry;
+        m_specialSum += other.m_specialSum;
+        carry();
+    }
+
+    double value() const
+    {
+        if (m_special)
+            return m_specialSum;
+
+        // fold the carries back into the top bin while they fit, so that totals that cancel stay exact
+        std::int64_t sums[bins]{};
+        std::copy(m_bins, m_bins + bins, sums);
+        double carried{ 0.0 };
+        if (m_carry > -(std::int64_t{ 1 } << 30) && m_carry < (std::int64_t{ 1 } << 30))
+            sums[0] += m_carry * (std::int64_t{ 1 } << binBits);
+        else
+            carried = std::ldexp(static_cast<double>(m_carry), m_unitExponent[0] + binBits); // dwarfs the bins
+
+        // smallest first, so the low bins can still decide the rounding
+        double total{ 0.0 };
+        for (int bin{ bins - 1 }; bin >= 0; --bin)
+            total += std::ldexp(static_cast<double>(sums[bin]), m_unitExponent[bin]);
+        return std::ldexp(total + carried, -m_scale);
+    }
+
+private:
+    // pieces in a bin are at most 2^32 units, so 2^20 of them add up exactly as doubles
+    static constexpr std::size_t blockSize{ std::size_t{ 1 } << 20 };
+
+    void addBlock(std::span<const double> values)
+    {
+        double sums[bins]{};
+        binBlock(values.data(), values.size(), std::ldexp(1.0, m_scale), m_rounder, sums);
+        for (int bin{ 0 }; bin < bins; ++bin)
+            m_bins[bin] += static_cast<std::int64_t>(std::ldexp(sums[bin], -m_unitExponent[bin]));
+        carry();
+    }
+
+    /* Moves everything above each bin's width up to the next bin, and above
+    the top bin's into m_carry, leaving every bin in [0, 2^32) units. A block
+    adds at most 2^52 units to a bin, so the bins never get near 2^63; m_carry
+    grows by at most one per value. */
+    void carry()
+    {
+        for (int bin{ bins - 1 }; bin >= 0; --bin)
+        {
+            int width{ bin > 0 ? m_unitExponent[bin - 1] - m_unitExponent[bin] : binBits };
+            std::int64_t carried{ m_bins[bin] >> width };
+            m_bins[bin] -= carried * (std::int64_t{ 1 } << width);
+            (bin > 0 ? m_bins[bin - 1] : m_carry) += carried;
+        }
+    }
+
+    bool m_special;
+    double m_specialSum{ 0.0 };
+    int m_scale{ 0 };
+    int m_unitExponent[bins]{};
+    double m_rounder[bins]{}; // all zero when every value is zero
+    std::int64_t m_bins[bins]{};
+    std::int64_t m_carry{ 0 }; // in units of 2^32 top-bin units
+};
+
+// runs body(chunk, index) on threads contiguous chunks of values, one per thread
+template <typename Body>
+void forEachChunk(std::span<const double> values, unsigned threads, Body body)
+{
+    std::size_t chunkSize{ (values.size() + threads - 1) / threads };
+    auto chunk{ [&](unsigned index) {
+        std::size_t first{ std::min(values.size(), index * chunkSize) };
+        return values.subspan(first, std::min(chunkSize, values.size() - first));
+    } };
+
+    std::vector<std::thread> workers;
+    for (unsigned index{ 1 }; index < threads; ++index)
+        workers.emplace_back([&, index] { body(chunk(index), index); });
+    body(chunk(0), 0);
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+// the reproducible sum of values on the given number of threads; the result doesn't depend on it
+inline double reproducible_sum(std::span<const double> values,
+                               unsigned threads = std::thread::hardware_concurrency())
+{
+    threads = std::max(threads, 1u);
+
+    std::vector<double> largest(threads, 0.0);
+    forEachChunk(values, threads, [&](std::span<const double> chunk, unsigned index) {
+        largest[index] = maxMagnitude(chunk);
+    });
+    double overall{ 0.0 };
+    for (double chunkLargest : largest)
+        overall = maxMagnitude(overall, chunkLargest);
+
+    std::vector<ReproducibleSum> partial(threads, ReproducibleSum{ overall });
+    forEachChunk(values, threads, [&](std::span<const double> chunk, unsigned index) {
+        partial[index].add(chunk);
+    });
+    for (unsigned index{ 1 }; index < threads; ++index)
+        partial[0].merge(partial[index]);
+    return partial[0].value();
+}
+
+#endif
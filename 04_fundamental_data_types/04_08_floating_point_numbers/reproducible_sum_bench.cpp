@@ -0,0 +1,131 @@
+/* Compares reproducible_sum with a plain parallel sum.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 -pthread reproducible_sum_bench.cpp -o reproducible_sum_bench
+
+Usage:
+reproducible_sum_bench [count] [threads]
+    sums count doubles (default 16777216) of mixed signs and magnitudes, and
+    count copies of 0.1 (ex7 in main.cpp, at scale), on 1, 2, ... threads
+    threads (default: the number of cores), best of 5 runs each. It prints
+    every plain sum, to show them drift with the thread count, and checks
+    that every reproducible sum -- and sums over random chunks merged in a
+    random order -- is the same bit for bit. */
+
+#include "reproducible_sum.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename Body>
+double bestMs(Body body)
+{
+    double best{ 0.0 };
+    for (int run{ 0 }; run < 5; ++run)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        body();
+        double ms{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+        if (run == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+// what most parallel sums do: a loop per thread, then the partial sums in thread order
+double plainSum(std::span<const double> values, unsigned threads)
+{
+    std::vector<double> partial(threads, 0.0);
+    forEachChunk(values, threads, [&](std::span<const double> chunk, unsigned index) {
+        double sum{ 0.0 };
+        for (double value : chunk)
+            sum += value;
+        partial[index] = sum;
+    });
+    double total{ 0.0 };
+    for (double sum : partial)
+        total += sum;
+    return total;
+}
+
+// values cut at random places, summed piece by piece and merged in a random order
+double shuffledChunkSum(std::span<const double> values, std::mt19937 &rng)
+{
+    std::vector<std::span<const double>> chunks;
+    std::uniform_int_distribution<std::size_t> chunkSize{ 0, values.size() / 8 + 1 };
+    for (std::size_t first{ 0 }; first < values.size();)
+    {
+        std::size_t size{ std::min(chunkSize(rng), values.size() - first) };
+        chunks.push_back(values.subspan(first, size));
+        first += size;
+    }
+    std::shuffle(chunks.begin(), chunks.end(), rng);
+
+    double largest{ 0.0 };
+    for (std::span<const double> chunk : chunks)
+        largest = maxMagnitude(largest, maxMagnitude(chunk));
+
+    ReproducibleSum total{ largest };
+    for (std::span<const double> chunk : chunks)
+    {
+        ReproducibleSum partial{ largest };
+        partial.add(chunk);
+        total.merge(partial);
+    }
+    return total.value();
+}
+
+bool compare(const char *name, const std::vector<double> &values, unsigned maxThreads, std::mt19937 &rng)
+{
+    std::cout << name << '\n'
+              << "threads  plain ms  plain sum                reproducible ms  reproducible sum\n";
+
+    double expected{ reproducible_sum(values, 1) };
+    bool ok{ true };
+    for (unsigned threads{ 1 }; threads <= maxThreads; ++threads)
+    {
+        double plain{};
+        double plainMs{ bestMs([&] { plain = plainSum(values, threads); }) };
+        double reproducible{};
+        double reproducibleMs{ bestMs([&] { reproducible = reproducible_sum(values, threads); }) };
+        ok = ok && reproducible == expected;
+
+        std::cout << std::setw(7) << threads << std::fixed << std::setprecision(2) << std::setw(10) << plainMs
+                  << "  " << std::defaultfloat << std::setprecision(17) << std::setw(23) << plain << std::fixed
+                  << std::setprecision(2) << std::setw(17) << reproducibleMs << "  " << std::defaultfloat
+                  << std::setprecision(17) << reproducible << '\n';
+    }
+
+    for (int trial{ 0 }; trial < 10; ++trial)
+        ok = ok && shuffledChunkSum(values, rng) == expected;
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{ 1 } << 24 };
+    unsigned maxThreads{ argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                                  : std::max(std::thread::hardware_concurrency(), 1u) };
+
+    std::mt19937 rng{ 42 };
+    std::uniform_real_distribution<double> mantissa{ -1.0, 1.0 };
+    std::uniform_int_distribution<int> exponent{ -20, 20 };
+    std::vector<double> mixed(count);
+    for (double &value : mixed)
+        value = std::ldexp(mantissa(rng), exponent(rng));
+
+    std::vector<double> tenths(count, 0.1);
+
+    bool ok{ compare("mixed magnitudes", mixed, maxThreads, rng) };
+    ok = compare("0.1, count times", tenths, maxThreads, rng) && ok;
+    if (!ok)
+    {
+        std::cerr << "a reproducible sum changed with the thread count or chunking!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef SUM_PATH_H
+#define SUM_PATH_H
+
+/* Which SIMD kernels the summation headers in this folder run: AVX2 when the
+CPU has it (see cpu_features.h), NEON on ARM64, plain C++ otherwise. */
+
+#include "../../cpu_features.h"
+
+enum class SumPath
+{
+    scalar,
+    avx2,
+    neon,
+};
+
+inline const char *sumPathName(SumPath path)
+{
+    switch (path)
+    {
+    case SumPath::avx2: return "avx2";
+    case SumPath::neon: return "neon";
+    default:            return "scalar";
+    }
+}
+
+// the widest path this CPU (and OS) can run
+inline SumPath detectSumPath()
+{
+    const CpuFeatures &cpu{ cpuFeatures() };
+    if (cpu.avx2)
+        return SumPath::avx2;
+    if (cpu.neon)
+        return SumPath::neon;
+    return SumPath::scalar;
+}
+
+inline SumPath g_sumPath{ detectSumPath() };
+
+inline SumPath activeSumPath()
+{
+    return g_sumPath;
+}
+
+// forces a narrower path, e.g. to compare paths; unsupported requests fall back to scalar
+inline void forceSumPath(SumPath path)
+{
+    bool supported{ path == SumPath::scalar || path == detectSumPath() };
+    g_sumPath = supported ? path : SumPath::scalar;
+}
+
+#endif
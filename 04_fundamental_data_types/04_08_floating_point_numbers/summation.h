@@ -0,0 +1,364 @@
+#ifndef SUMMATION_H
+#define SUMMATION_H
+
+/* Four ways to add up an array of doubles, from fastest to most accurate.
+
+ex7 in main.cpp adds 0.1 ten times and gets 0.99999999999999989: every +
+rounds, and a running total keeps rounding at its own, growing size, so the
+error grows with the length of the array.
+
+- naive: the plain running total. The error can grow with count.
+- pairwise: sums 128-value blocks, then adds neighbouring partial sums in a
+  tree, so the error grows only with log2(count), for hardly any extra work.
+- kahan: a running total plus a compensation term that carries the low bits
+  each addition lost into the next one. It is accurate unless a value is
+  bigger than the running total, e.g. when large values cancel.
+- neumaier: Kahan with that case fixed. Each step keeps the lost bits of
+  whichever of total and value is smaller, so the error stays about one
+  rounding of the result, plus a term that only matters for sums that almost
+  cancel.
+
+Each has a scalar kernel and AVX2/NEON kernels that run the same algorithm
+in several independent lanes and combine the lanes at the end, so their
+results can differ from the scalar one in the last bits, within the same
+error bounds. The vector Neumaier kernels find the lost bits with Knuth's
+TwoSum, which needs no comparison. */
+
+#include "sum_path.h"
+#include <cmath>
+#include <cstddef>
+#include <span>
+
+enum class SumMethod
+{
+    naive,
+    pairwise,
+    kahan,
+    neumaier,
+};
+
+inline const char *sumMethodName(SumMethod method)
+{
+    switch (method)
+    {
+    case SumMethod::pairwise: return "pairwise";
+    case SumMethod::kahan:    return "kahan";
+    case SumMethod::neumaier: return "neumaier";
+    default:                  return "naive";
+    }
+}
+
+/* Kernels, over count values. */
+
+// one step of Neumaier's sum: total += value, with what that loses added to compensation
+inline void neumaierAdd(double &total, double &compensation, double value)
+{
+    double sum{ total + value };
+    if (std::abs(total) >= std::abs(value))
+        compensation += (total - sum) + value;
+    else
+        compensation += (value - sum) + total;
+    total = sum;
+}
+
+inline double sumNaiveScalar(const double *values, std::size_t count)
+{
+    double total{ 0.0 };
+    for (std::size_t i{ 0 }; i < count; ++i)
+        total += values[i];
+    return total;
+}
+
+/* Inf - Inf in a compensation term is NaN, which then spreads to the total,
+so a compensated sum that isn't finite is redone as a plain one: that gives
+the Inf, -Inf or NaN the input adds up to. */
+inline double finiteOrNaive(double result, const double *values, std::size_t count)
+{
+    return std::isfinite(result) ? result : sumNaiveScalar(values, count);
+}
+
+inline double sumKahanScalar(const double *values, std::size_t count)
+{
+    double total{ 0.0 };
+    double compensation{ 0.0 }; // minus the low bits lost so far
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        double value{ values[i] - compensation };
+        double sum{ total + value };
+        compensation = (sum - total) - value;
+        total = sum;
+    }
+    return finiteOrNaive(total, values, count);
+}
+
+inline double sumNeumaierScalar(const double *values, std::size_t count)
+{
+    double total{ 0.0 };
+    double compensation{ 0.0 };
+    for (std::size_t i{ 0 }; i < count; ++i)
+        neumaierAdd(total, compensation, values[i]);
+    return finiteOrNaive(total + compensation, values, count);
+}
+
+// splits the range in halves down to blocks, which leaf adds up
+inline double sumPairwise(const double *values, std::size_t count, double (*leaf)(const double *, std::size_t))
+{
+    constexpr std::size_t block{ 128 };
+    if (count <= block)
+        return leaf(values, count);
+
+    // split at a multiple of the block size, so the leaves get whole vectors
+    std::size_t half{ (count / 2 + block - 1) / block * block };
+    return sumPairwise(values, half, leaf) + sumPairwise(values + half, count - half, leaf);
+}
+
+inline double sumPairwiseScalar(const double *values, std::size_t count)
+{
+    return sumPairwise(values, count, sumNaiveScalar);
+}
+
+#if defined(SIMD_X86)
+
+SIMD_TARGET("avx2")
+inline double addLanesAvx2(__m256d lanes)
+{
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(lanes), _mm256_extractf128_pd(lanes, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+// the lanes of a vector added to a Neumaier sum, keeping their rounding errors
+SIMD_TARGET("avx2")
+inline void neumaierAddLanesAvx2(double &total, double &compensation, __m256d lanes)
+{
+    double values[4];
+    _mm256_storeu_pd(values, lanes);
+    for (double value : values)
+        neumaierAdd(total, compensation, value);
+}
+
+SIMD_TARGET("avx2")
+inline double sumNaiveAvx2(const double *values, std::size_t count)
+{
+    // four vectors, so four additions are in flight at once
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+    std::size_t i{ 0 };
+    for (; i + 16 <= count; i += 16)
+    {
+        sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(values + i));
+        sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(values + i + 4));
+        sum2 = _mm256_add_pd(sum2, _mm256_loadu_pd(values + i + 8));
+        sum3 = _mm256_add_pd(sum3, _mm256_loadu_pd(values + i + 12));
+    }
+    for (; i + 4 <= count; i += 4)
+        sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(values + i));
+
+    double total{ addLanesAvx2(_mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3))) };
+    return total + sumNaiveScalar(values + i, count - i);
+}
+
+SIMD_TARGET("avx2")
+inline double sumPairwiseAvx2(const double *values, std::size_t count)
+{
+    return sumPairwise(values, count, sumNaiveAvx2);
+}
+
+SIMD_TARGET("avx2")
+inline void kahanAddAvx2(__m256d &total, __m256d &compensation, __m256d values)
+{
+    __m256d value = _mm256_sub_pd(values, compensation);
+    __m256d sum = _mm256_add_pd(total, value);
+    compensation = _mm256_sub_pd(_mm256_sub_pd(sum, total), value);
+    total = sum;
+}
+
+SIMD_TARGET("avx2")
+inline double sumKahanAvx2(const double *values, std::size_t count)
+{
+    // four vectors of lanes, as every step waits on the last one's four additions
+    __m256d total0 = _mm256_setzero_pd(), total1 = total0, total2 = total0, total3 = total0;
+    __m256d compensation0 = total0, compensation1 = total0, compensation2 = total0, compensation3 = total0;
+    std::size_t i{ 0 };
+    for (; i + 16 <= count; i += 16)
+    {
+        kahanAddAvx2(total0, compensation0, _mm256_loadu_pd(values + i));
+        kahanAddAvx2(total1, compensation1, _mm256_loadu_pd(values + i + 4));
+        kahanAddAvx2(total2, compensation2, _mm256_loadu_pd(values + i + 8));
+        kahanAddAvx2(total3, compensation3, _mm256_loadu_pd(values + i + 12));
+    }
+
+    double total{ 0.0 };
+    double compensation{ -addLanesAvx2(_mm256_add_pd(_mm256_add_pd(compensation0, compensation1),
+                                                     _mm256_add_pd(compensation2, compensation3))) };
+    for (__m256d lanes : { total0, total1, total2, total3 })
+        neumaierAddLanesAvx2(total, compensation, lanes);
+    neumaierAdd(total, compensation, sumKahanScalar(values + i, count - i));
+    return finiteOrNaive(total + compensation, values, count);
+}
+
+SIMD_TARGET("avx2")
+inline void neumaierAddAvx2(__m256d &total, __m256d &compensation, __m256d values)
+{
+    // Knuth's TwoSum finds the same lost bits as neumaierAdd without comparing magnitudes
+    __m256d sum = _mm256_add_pd(total, values);
+    __m256d valuePart = _mm256_sub_pd(sum, total);
+    __m256d totalPart = _mm256_sub_pd(sum, valuePart);
+    __m256d lost = _mm256_add_pd(_mm256_sub_pd(total, totalPart), _mm256_sub_pd(values, valuePart));
+    compensation = _mm256_add_pd(compensation, lost);
+    total = sum;
+}
+
+SIMD_TARGET("avx2")
+inline double sumNeumaierAvx2(const double *values, std::size_t count)
+{
+    __m256d total0 = _mm256_setzero_pd(), total1 = total0, total2 = total0, total3 = total0;
+    __m256d compensation0 = total0, compensation1 = total0, compensation2 = total0, compensation3 = total0;
+    std::size_t i{ 0 };
+    for (; i + 16 <= count; i += 16)
+    {
+        neumaierAddAvx2(total0, compensation0, _mm256_loadu_pd(values + i));
+        neumaierAddAvx2(total1, compensation1, _mm256_loadu_pd(values + i + 4));
+        neumaierAddAvx2(total2, compensation2, _mm256_loadu_pd(values + i + 8));
+        neumaierAddAvx2(total3, compensation3, _mm256_loadu_pd(values + i + 12));
+    }
+
+    double total{ 0.0 };
+    double compensation{ addLanesAvx2(_mm256_add_pd(_mm256_add_pd(compensation0, compensation1),
+                                                    _mm256_add_pd(compensation2, compensation3))) };
+    for (__m256d lanes : { total0, total1, total2, total3 })
+        neumaierAddLanesAvx2(total, compensation, lanes);
+    for (; i < count; ++i)
+        neumaierAdd(total, compensation, values[i]);
+    return finiteOrNaive(total + compensation, values, count);
+}
+
+#endif // SIMD_X86
+
+#if defined(SIMD_NEON)
+
+inline void neumaierAddLanesNeon(double &total, double &compensation, float64x2_t lanes)
+{
+    neumaierAdd(total, compensation, vgetq_lane_f64(lanes, 0));
+    neumaierAdd(total, compensation, vgetq_lane_f64(lanes, 1));
+}
+
+inline double sumNaiveNeon(const double *values, std::size_t count)
+{
+    float64x2_t sum0 = vdupq_n_f64(0.0), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+    std::size_t i{ 0 };
+    for (; i + 8 <= count; i += 8)
+    {
+        sum0 = vaddq_f64(sum0, vld1q_f64(values + i));
+        sum1 = vaddq_f64(sum1, vld1q_f64(values + i + 2));
+        sum2 = vaddq_f64(sum2, vld1q_f64(values + i + 4));
+        sum3 = vaddq_f64(sum3, vld1q_f64(values + i + 6));
+    }
+    for (; i + 2 <= count; i += 2)
+        sum0 = vaddq_f64(sum0, vld1q_f64(values + i));
+
+    double total{ vaddvq_f64(vaddq_f64(vaddq_f64(sum0, sum1), vaddq_f64(sum2, sum3))) };
+    return total + sumNaiveScalar(values + i, count - i);
+}
+
+inline double sumPairwiseNeon(const double *values, std::size_t count)
+{
+    return sumPairwise(values, count, sumNaiveNeon);
+}
+
+inline void kahanAddNeon(float64x2_t &total, float64x2_t &compensation, float64x2_t values)
+{
+    float64x2_t value = vsubq_f64(values, compensation);
+    float64x2_t sum = vaddq_f64(total, value);
+    compensation = vsubq_f64(vsubq_f64(sum, total), value);
+    total = sum;
+}
+
+inline double sumKahanNeon(const double *values, std::size_t count)
+{
+    float64x2_t total0 = vdupq_n_f64(0.0), total1 = total0;
+    float64x2_t compensation0 = total0, compensation1 = total0;
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        kahanAddNeon(total0, compensation0, vld1q_f64(values + i));
+        kahanAddNeon(total1, compensation1, vld1q_f64(values + i + 2));
+    }
+
+    double total{ 0.0 };
+    double compensation{ -vaddvq_f64(vaddq_f64(compensation0, compensation1)) };
+    neumaierAddLanesNeon(total, compensation, total0);
+    neumaierAddLanesNeon(total, compensation, total1);
+    neumaierAdd(total, compensation, sumKahanScalar(values + i, count - i));
+    return finiteOrNaive(total + compensation, values, count);
+}
+
+inline void neumaierAddNeon(float64x2_t &total, float64x2_t &compensation, float64x2_t values)
+{
+    // Knuth's TwoSum finds the same lost bits as neumaierAdd without comparing magnitudes
+    float64x2_t sum = vaddq_f64(total, values);
+    float64x2_t valuePart = vsubq_f64(sum, total);
+    float64x2_t totalPart = vsubq_f64(sum, valuePart);
+    float64x2_t lost = vaddq_f64(vsubq_f64(total, totalPart), vsubq_f64(values, valuePart));
+    compensation = vaddq_f64(compensation, lost);
+    total = sum;
+}
+
+inline double sumNeumaierNeon(const double *values, std::size_t count)
+{
+    float64x2_t total0 = vdupq_n_f64(0.0), total1 = total0;
+    float64x2_t compensation0 = total0, compensation1 = total0;
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        neumaierAddNeon(total0, compensation0, vld1q_f64(values + i));
+        neumaierAddNeon(total1, compensation1, vld1q_f64(values + i + 2));
+    }
+
+    double total{ 0.0 };
+    double compensation{ vaddvq_f64(vaddq_f64(compensation0, compensation1)) };
+    neumaierAddLanesNeon(total, compensation, total0);
+    neumaierAddLanesNeon(total, compensation, total1);
+    for (; i < count; ++i)
+        neumaierAdd(total, compensation, values[i]);
+    return finiteOrNaive(total + compensation, values, count);
+}
+
+#endif // SIMD_NEON
+
+// the sum of values by the given method, on the widest path the CPU supports
+inline double array_sum(std::span<const double> values, SumMethod method = SumMethod::naive)
+{
+    const double *data{ values.data() };
+    std::size_t count{ values.size() };
+    switch (activeSumPath())
+    {
+#if defined(SIMD_X86)
+    case SumPath::avx2:
+        switch (method)
+        {
+        case SumMethod::pairwise: return sumPairwiseAvx2(data, count);
+        case SumMethod::kahan:    return sumKahanAvx2(data, count);
+        case SumMethod::neumaier: return sumNeumaierAvx2(data, count);
+        default:                  return sumNaiveAvx2(data, count);
+        }
+#elif defined(SIMD_NEON)
+    case SumPath::neon:
+        switch (method)
+        {
+        case SumMethod::pairwise: return sumPairwiseNeon(data, count);
+        case SumMethod::kahan:    return sumKahanNeon(data, count);
+        case SumMethod::neumaier: return sumNeumaierNeon(data, count);
+        default:                  return sumNaiveNeon(data, count);
+        }
+#endif
+    default:
+        switch (method)
+        {
+        case SumMethod::pairwise: return sumPairwiseScalar(data, count);
+        case SumMethod::kahan:    return sumKahanScalar(data, count);
+        case SumMethod::neumaier: return sumNeumaierScalar(data, count);
+        default:                  return sumNaiveScalar(data, count);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,246 @@
+/* Compares the accuracy and the speed of the summation methods.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 summation_bench.cpp -o summation_bench
+
+Usage:
+summation_bench [count]
+    builds arrays of count doubles (default 1048576) that are hard to add up:
+    0.1 over and over (ex7 in main.cpp, at scale), mixed magnitudes, and big
+    values that cancel around small ones. It sums each with every method on
+    every path the CPU supports, plus reproducible_sum, and prints the
+    throughput and the error in units in the last place (ulps) of the exact
+    sum, which is worked out with integers. Last it checks that every method
+    adds arrays holding an Inf or a NaN up to Inf, -Inf or NaN as it should. */
+
+#include "reproducible_sum.h"
+#include "summation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+/* The exact sum of any doubles, as a 2^-1074 fixed-point number in 32-bit
+digits (kept in int64s so they can run over for a while). */
+class ExactSum
+{
+public:
+    void add(double value)
+    {
+        if (value == 0.0)
+            return;
+
+        int exponent{};
+        double mantissa{ std::frexp(std::abs(value), &exponent) };
+        // value = significand * 2^(exponent - 53), with significand < 2^53 a whole number
+        exponent -= 53;
+        if (exponent < -1074)
+        {
+            mantissa = std::ldexp(mantissa, exponent + 1074);
+            exponent = -1074;
+        }
+        auto significand{ static_cast<std::uint64_t>(std::ldexp(mantissa, 53)) };
+        int bit{ exponent + 1074 };
+        int shift{ bit % 32 };
+
+        std::int64_t sign{ value < 0.0 ? -1 : 1 };
+        std::uint64_t low{ (significand & ((std::uint64_t{ 1 } << (32 - shift)) - 1)) << shift };
+        std::uint64_t high{ significand >> (32 - shift) };
+        m_digits[bit / 32] += sign * static_cast<std::int64_t>(low);
+        m_digits[bit / 32 + 1] += sign * static_cast<std::int64_t>(high & 0xFFFFFFFF);
+        m_digits[bit / 32 + 2] += sign * static_cast<std::int64_t>(high >> 32);
+    }
+
+    // the sum, rounded to the nearest double (give or take one in the last place)
+    double value() const
+    {
+        std::int64_t digits[count];
+        std::copy(m_digits, m_digits + count, digits);
+        bool negative{ normalize(digits) };
+        if (negative)
+        {
+            for (std::int64_t &digit : digits)
+                digit = -digit;
+            normalize(digits);
+        }
+
+        double magnitude{ 0.0 };
+        for (int digit{ 0 }; digit < count; ++digit)
+            magnitude += std::ldexp(static_cast<double>(digits[digit]), 32 * digit - 1074);
+        return negative ? -magnitude : magnitude;
+    }
+
+private:
+    static constexpr int count{ 70 }; // 2^-1074 up to well past 2^1024
+
+    // carries up, leaving every digit but the top one in [0, 2^32); true if the total is negative
+    static bool normalize(std::int64_t *digits)
+    {
+        for (int digit{ 0 }; digit + 1 < count; ++digit)
+        {
+            std::int64_t carry{ digits[digit] >> 32 };
+            digits[digit] -= carry * (std::int64_t{ 1 } << 32);
+            digits[digit + 1] += carry;
+        }
+        return digits[count - 1] < 0;
+    }
+
+    std::int64_t m_digits[count]{};
+};
+
+// |result - exact| in ulps of the exact sum, itself summed exactly
+double ulpsOff(const std::vector<double> &values, double result, double exact)
+{
+    ExactSum error;
+    for (double value : values)
+        error.add(value);
+    error.add(-result);
+    double ulp{ exact == 0.0 ? std::ldexp(1.0, -1074) : std::abs(exact - std::nextafter(exact, 0.0)) };
+    return std::abs(error.value()) / ulp;
+}
+
+template <typename Body>
+double gigabytesPerSecond(const std::vector<double> &values, Body body)
+{
+    // repeat until about 256 MiB have been read, so small arrays are timed long enough
+    std::size_t bytes{ values.size() * sizeof(double) };
+    std::size_t rounds{ (std::size_t{ 256 } << 20) / bytes + 1 };
+    double sink{ body() }; // warm up the caches
+
+    double best{ 0.0 };
+    for (int run{ 0 }; run < 5; ++run)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        for (std::size_t round{ 0 }; round < rounds; ++round)
+            sink += body();
+        double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+        double rate{ static_cast<double>(bytes * rounds) / seconds / 1e9 };
+        best = std::max(best, rate);
+    }
+    volatile double keep{ sink };
+    (void)keep;
+    return best;
+}
+
+void report(const std::vector<double> &values, const char *name)
+{
+    ExactSum exactSum;
+    for (double value : values)
+        exactSum.add(value);
+    double exact{ exactSum.value() };
+    std::cout << name << ", exact sum " << std::setprecision(17) << exact << '\n';
+
+    auto print{ [&](const std::string &label, double rate, double result) {
+        std::cout << "  " << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(8) << rate << " GB/s  " << std::defaultfloat << std::setprecision(3) << std::setw(10)
+                  << ulpsOff(values, result, exact) << " ulps\n";
+    } };
+
+    SumPath best{ activeSumPath() };
+    for (SumPath path : { SumPath::scalar, SumPath::avx2, SumPath::neon })
+    {
+        forceSumPath(path);
+        if (activeSumPath() != path)
+            continue;
+
+        for (SumMethod method : { SumMethod::naive, SumMethod::pairwise, SumMethod::kahan, SumMethod::neumaier })
+        {
+            double rate{ gigabytesPerSecond(values, [&] { return array_sum(values, method); }) };
+            print(std::string{ sumMethodName(method) } + ", " + sumPathName(path), rate, array_sum(values, method));
+        }
+    }
+    forceSumPath(best);
+
+    double rate{ gigabytesPerSecond(values, [&] { return reproducible_sum(values, 1); }) };
+    print("reproducible_sum", rate, reproducible_sum(values, 1));
+}
+
+// every method on every path, on count ones with Infs and NaNs dropped in at a few places
+bool checkNonFinite(std::size_t count)
+{
+    constexpr double inf{ std::numeric_limits<double>::infinity() };
+    constexpr double nan{ std::numeric_limits<double>::quiet_NaN() };
+    struct Case
+    {
+        const char *name;
+        double first;
+        double second; // 1.0 for none
+        double expected;
+    };
+    const Case cases[]{
+        { "Inf", inf, 1.0, inf },
+        { "-Inf", -inf, 1.0, -inf },
+        { "Inf and -Inf", inf, -inf, nan },
+        { "NaN", nan, 1.0, nan },
+    };
+
+    bool ok{ true };
+    SumPath best{ activeSumPath() };
+    for (SumPath path : { SumPath::scalar, SumPath::avx2, SumPath::neon })
+    {
+        forceSumPath(path);
+        if (activeSumPath() != path)
+            continue;
+
+        for (const Case &check : cases)
+        {
+            // at the start, in the middle, and in the scalar tail of the vector kernels
+            for (std::size_t at : { std::size_t{ 0 }, count / 2, count - 1 })
+            {
+                std::vector<double> values(count, 1.0);
+                values[at] = check.first;
+                values[(at + count / 3) % count] = check.second;
+                for (SumMethod method : { SumMethod::naive, SumMethod::pairwise, SumMethod::kahan, SumMethod::neumaier })
+                {
+                    double result{ array_sum(values, method) };
+                    bool same{ std::isnan(check.expected) ? std::isnan(result) : result == check.expected };
+                    if (!same)
+                    {
+                        std::cout << "  " << check.name << " at " << at << ": " << sumMethodName(method) << ", "
+                                  << sumPathName(path) << " gave " << result << '\n';
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+    forceSumPath(best);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count{ argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{ 1 } << 20 };
+    std::mt19937 rng{ 42 };
+    std::uniform_real_distribution<double> unit{ -1.0, 1.0 };
+    std::uniform_int_distribution<int> exponent{ -30, 30 };
+
+    report(std::vector<double>(count, 0.1), "0.1, count times");
+
+    std::vector<double> mixed(count);
+    for (double &value : mixed)
+        value = std::ldexp(unit(rng), exponent(rng));
+    report(mixed, "mixed magnitudes");
+
+    // as many 1e16s as -1e16s, scattered among small values: the answer is the sum of the small ones
+    std::vector<double> cancelling(count);
+    for (std::size_t i{ 0 }; i < count; ++i)
+        cancelling[i] = i < count / 4 ? 1e16 : i < count / 2 ? -1e16 : unit(rng);
+    std::shuffle(cancelling.begin(), cancelling.end(), rng);
+    report(cancelling, "big values cancelling");
+
+    if (!checkNonFinite(std::max(count, std::size_t{ 3 })))
+    {
+        std::cerr << "a sum with an Inf or a NaN in it came out wrong!\n";
+        return 1;
+    }
+    std::cout << "Infs and NaNs: every method agrees with naive\n";
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+/* Allocation counting for the benchmarks.
+
+Replacing the global operator new lets a benchmark report how many heap
+allocations a pass made: read allocationCount() before and after. The count is
+atomic, since some benchmarks allocate on several threads.
+
+These are the program's replacement operators, not inline functions, so include
+this header from exactly one source file per program (the benchmark's main
+file). None of the three is inlined either: gcc would otherwise see malloc on
+one side of a new/delete pair and the plain operator on the other, and warn that
+they don't match (-Wmismatched-new-delete). */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<std::size_t> g_allocations{ 0 };
+
+inline std::size_t allocationCount()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p{ std::malloc(size ? size : 1) })
+        return p;
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void *p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/* Which SIMD instruction sets the CPU running the program has.
+
+Every module with vectorized kernels (normalize_name_simd.h, number_stats.h,
+add_arrays.cpp, polygons.h and sum_path.h) picks its path from these flags, so
+the CPUID checks live in one place. Each module keeps its own path enum, since
+each has kernels for a different set of instruction sets.
+
+SIMD_X86 or SIMD_NEON says which family this build targets, with the matching
+intrinsics header included. SIMD_TARGET(isa) goes in front of a function that
+uses a wider instruction set than the build's baseline. */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC lets any function use any intrinsic, gcc and clang need to be told
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+struct CpuFeatures
+{
+    bool sse2{};
+    bool avx2{};
+    bool avx512f{};
+    bool neon{};
+};
+
+/* An instruction set counts only if the OS saves its registers on a context
+switch too, which is what the xgetbv checks are for. */
+inline CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features{};
+#if defined(SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4]{};
+    __cpuid(info, 0);
+    int maxLeaf{ info[0] };
+
+    __cpuid(info, 1);
+    features.sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave{ (info[2] & (1 << 27)) != 0 };
+    bool avx{ (info[2] & (1 << 28)) != 0 };
+    unsigned long long xcr0{ (osxsave && avx) ? _xgetbv(0) : 0 };
+
+    if (maxLeaf >= 7 && (xcr0 & 0x6) == 0x6)
+    {
+        __cpuidex(info, 7, 0);
+        features.avx2 = (info[1] & (1 << 5)) != 0;
+        features.avx512f = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE0) == 0xE0;
+    }
+#else
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2") != 0;
+    features.avx2 = __builtin_cpu_supports("avx2") != 0;
+    features.avx512f = __builtin_cpu_supports("avx512f") != 0;
+#endif
+#elif defined(SIMD_NEON)
+    features.neon = true; // NEON is part of the ARM64 baseline
+#endif
+    return features;
+}
+
+// detected on first use, which is while the program starts up
+inline const CpuFeatures &cpuFeatures()
+{
+    static const CpuFeatures features{ detectCpuFeatures() };
+    return features;
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+/* Read-only view of a whole file.
+
+The file is memory mapped, and the kernel is told it will be read front to
+back, so it reads ahead and drops pages behind. On Windows it is read into
+memory instead. normalize_name's parallel mode maps its input through this,
+and so does MappedNumbers in the chapter 2 quiz.
+
+Only regular files can be mapped. Pipes, terminals and devices (/dev/stdin fed
+from a pipe, say) have no size to map, so for those ok() is false and errno is
+ENODEV; canMap() tells them apart beforehand, so callers can stream them
+instead. */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+public:
+    explicit MappedFile(const char *path)
+    {
+#if defined(_WIN32)
+        std::FILE *file{ std::fopen(path, "rb") };
+        if (!file)
+            return;
+        std::size_t count{};
+        std::vector<char> block(1 << 20);
+        while ((count = std::fread(block.data(), 1, block.size(), file)) > 0)
+            m_buffer.insert(m_buffer.end(), block.data(), block.data() + count);
+        m_ok = !std::ferror(file);
+        std::fclose(file);
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#else
+        int fd{ ::open(path, O_RDONLY) };
+        if (fd < 0)
+            return;
+
+        struct stat info{};
+        bool regular{ ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) };
+        if (regular)
+        {
+            m_size = static_cast<std::size_t>(info.st_size);
+            if (m_size == 0)
+            {
+                m_ok = true;
+            }
+            else
+            {
+                void *data{ ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0) };
+                if (data != MAP_FAILED)
+                {
+                    ::madvise(data, m_size, MADV_SEQUENTIAL);
+                    m_data = static_cast<const char *>(data);
+                    m_ok = true;
+                }
+            }
+        }
+        ::close(fd);
+        if (!regular)
+            errno = ENODEV;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if !defined(_WIN32)
+        if (m_data)
+            ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+    }
+
+    // true if path is a regular file, which the constructor can map
+    static bool canMap(const char *path)
+    {
+#if defined(_WIN32)
+        (void)path;
+        return true; // read, not mapped, so anything goes
+#else
+        struct stat info{};
+        return ::stat(path, &info) == 0 && S_ISREG(info.st_mode);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool ok() const { return m_ok; }
+    const char *data() const { return m_data; } // page aligned when mapped
+    std::size_t size() const { return m_size; }
+
+private:
+    const char *m_data{ nullptr };
+    std::size_t m_size{ 0 };
+    bool m_ok{ false };
+#if defined(_WIN32)
+    std::vector<char> m_buffer;
+#endif
+};
+
+#endif
@@ -1,42 +1,350 @@
-#include <iostream>
+#include "mapped_file.h"
+#include "normalize_name.h"
 #include <algorithm>
-#include <cctype>
-#include <locale>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Batch mode
+
+Reading one line with std::getline and writing it with std::endl flushes the
+output once per name, which is far too slow for multi-GB dumps. In batch mode the
+input is read in large blocks with std::fread, every line is normalized straight
+from the block into a single output buffer, and that buffer is only written out
+once it holds at least blockSize bytes. */
+
+constexpr std::size_t blockSize{ 1 << 20 }; // 1 MiB per read and per write
+
+struct BatchStats
+{
+    std::size_t lines{};
+    std::size_t bytes{};
+    double seconds{};
+};
+
+// normalizes every line of in and writes the results to out, one per line
+// returns false if reading or writing failed
+bool normalize_stream(std::FILE *in, std::FILE *out, BatchStats &stats)
+{
+    std::vector<char> block(blockSize);
+    std::string output;
+    output.reserve(blockSize + blockSize / 4);
+    std::string pending; // a line split across two blocks
+
+    // normalizes straight from the input block into the output buffer
+    auto emit = [&](std::string_view s) {
+        std::size_t offset{ output.size() };
+        output.resize(offset + s.size() + 1);
+        offset += normalize_name(s, output.data() + offset);
+        output[offset++] = '\n';
+        output.resize(offset);
+        ++stats.lines;
+
+        if (output.size() >= blockSize)
+        {
+            if (std::fwrite(output.data(), 1, output.size(), out) != output.size())
+                return false;
+            output.clear();
+        }
+        return true;
+    };
+
+    auto start{ std::chrono::steady_clock::now() };
+
+    std::size_t count{};
+    while ((count = std::fread(block.data(), 1, block.size(), in)) > 0)
+    {
+        stats.bytes += count;
+
+        const char *first{ block.data() };
+        const char *last{ first + count };
+        while (first != last)
+        {
+            const char *newline{ static_cast<const char *>(std::memchr(first, '\n', last - first)) };
+            if (!newline)
+            {
+                pending.append(first, last);
+                break;
+            }
+
+            if (pending.empty())
+            {
+                if (!emit(std::string_view(first, newline - first)))
+                    return false;
+            }
+            else
+            {
+                pending.append(first, newline);
+                if (!emit(pending))
+                    return false;
+                pending.clear();
+            }
+
+            first = newline + 1;
+        }
+    }
+
+    if (std::ferror(in))
+        return false;
+
+    if (!pending.empty() && !emit(pending)) // last line had no trailing newline
+        return false;
+
+    if (std::fwrite(output.data(), 1, output.size(), out) != output.size() || std::fflush(out) != 0)
+        return false;
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void report(const BatchStats &stats, unsigned threadCount = 1)
+{
+    double seconds{ stats.seconds > 0.0 ? stats.seconds : 1e-9 };
+    double megabytes{ stats.bytes / (1024.0 * 1024.0) };
+
+    std::fprintf(stderr, "normalized %zu lines (%.1f MB) in %.3f s: %.0f lines/s, %.1f MB/s [%s, %u thread%s]\n",
+                 stats.lines, megabytes, stats.seconds, stats.lines / seconds, megabytes / seconds,
+                 simdPathName(activeSimdPath()), threadCount, threadCount == 1 ? "" : "s");
+}
+
+int runBatch(const char *path)
+{
+    std::FILE *in{ stdin };
+    if (path && std::strcmp(path, "-") != 0)
+    {
+        in = std::fopen(path, "rb");
+        if (!in)
+        {
+            std::perror(path);
+            return 1;
+        }
+    }
+
+    BatchStats stats{};
+    bool ok{ normalize_stream(in, stdout, stats) };
+
+    if (in != stdin)
+        std::fclose(in);
+
+    if (!ok)
+    {
+        std::perror("normalize_name");
+        return 1;
+    }
+
+    report(stats);
+    return 0;
+}
+
+/* Parallel mode
+
+A single thread tops out at one core. In parallel mode the input file is memory
+mapped and cut into chunks of about chunkSize bytes, each ending on a newline.
+A pool of workers normalizes the chunks into per-chunk output buffers while the
+main thread writes finished chunks in their original order. Workers never run
+more than maxChunksInFlight chunks ahead of the writer, which bounds memory. */
+
+constexpr std::size_t chunkSize{ 8 << 20 }; // 8 MiB of input per task
 
-// trim from start (in place)
-inline void ltrim(std::string &s) {
-    s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch) {
-        return !std::isspace(ch);
-    }));
+struct Chunk
+{
+    const char *first{};
+    const char *last{};
+    std::string output;
+    std::size_t lines{};
+    bool done{};
+};
+
+// cuts [first, last) into pieces of about chunkSize bytes that end on a newline
+std::vector<Chunk> splitLines(const char *first, const char *last)
+{
+    std::vector<Chunk> chunks;
+    while (first != last)
+    {
+        const char *end{ last };
+        if (static_cast<std::size_t>(last - first) > chunkSize)
+        {
+            const char *newline{ static_cast<const char *>(
+                std::memchr(first + chunkSize, '\n', last - first - chunkSize)) };
+            end = newline ? newline + 1 : last;
+        }
+
+        Chunk chunk{};
+        chunk.first = first;
+        chunk.last = end;
+        chunks.push_back(std::move(chunk));
+        first = end;
+    }
+    return chunks;
 }
 
-// trim from end (in place)
-inline void rtrim(std::string &s) {
-    s.erase(std::find_if(s.rbegin(), s.rend(), [](unsigned char ch) {
-        return !std::isspace(ch);
-    }).base(), s.end());
+void normalize_chunk(Chunk &chunk)
+{
+    chunk.output.resize(static_cast<std::size_t>(chunk.last - chunk.first) + 1);
+    char *out{ chunk.output.data() };
+
+    const char *first{ chunk.first };
+    while (first != chunk.last)
+    {
+        const char *newline{ static_cast<const char *>(std::memchr(first, '\n', chunk.last - first)) };
+        const char *end{ newline ? newline : chunk.last };
+
+        out += normalize_name(std::string_view(first, end - first), out);
+        *out++ = '\n';
+        ++chunk.lines;
+
+        first = newline ? newline + 1 : chunk.last;
+    }
+
+    chunk.output.resize(static_cast<std::size_t>(out - chunk.output.data()));
 }
 
-void toLower(std::string &name)
+// normalizes every line of path on threadCount threads and writes them to out in order
+// returns false if the file couldn't be mapped or writing failed
+bool normalize_file_parallel(const char *path, std::FILE *out, unsigned threadCount, BatchStats &stats)
 {
-    for (int i = 0; i < name.length(); i++)
+    auto start{ std::chrono::steady_clock::now() };
+
+    MappedFile file{ path };
+    if (!file.ok())
+        return false;
+
+    std::vector<Chunk> chunks{ splitLines(file.data(), file.data() + file.size()) };
+    const std::size_t maxChunksInFlight{ std::size_t{ threadCount } * 4 };
+
+    std::mutex mutex;
+    std::condition_variable chunkDone;
+    std::condition_variable chunkWritten;
+    std::size_t nextChunk{ 0 };
+    std::size_t written{ 0 };
+    bool failed{ false };
+
+    auto worker = [&] {
+        while (true)
+        {
+            std::size_t index{};
+            {
+                std::unique_lock lock{ mutex };
+                chunkWritten.wait(lock, [&] {
+                    return failed || nextChunk >= chunks.size() || nextChunk < written + maxChunksInFlight;
+                });
+                if (failed || nextChunk >= chunks.size())
+                    return;
+                index = nextChunk++;
+            }
+
+            normalize_chunk(chunks[index]);
+
+            {
+                std::lock_guard lock{ mutex };
+                chunks[index].done = true;
+            }
+            chunkDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i{ 0 }; i < threadCount; ++i)
+        workers.emplace_back(worker);
+
+    for (Chunk &chunk : chunks)
     {
-        name[i] = std::tolower(name[i]);
+        {
+            std::unique_lock lock{ mutex };
+            chunkDone.wait(lock, [&] { return chunk.done; });
+        }
+
+        bool ok{ std::fwrite(chunk.output.data(), 1, chunk.output.size(), out) == chunk.output.size() };
+        stats.lines += chunk.lines;
+        std::string{}.swap(chunk.output); // give the memory back
+
+        {
+            std::lock_guard lock{ mutex };
+            ++written;
+            failed = !ok;
+        }
+        chunkWritten.notify_all();
+
+        if (!ok)
+            break;
     }
+
+    for (std::thread &thread : workers)
+        thread.join();
+
+    if (failed || std::fflush(out) != 0)
+        return false;
+
+    stats.bytes = file.size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
 }
 
-void normalize_name(std::string &name)
+constexpr unsigned maxThreads{ 256 };
+
+// a thread count from the command line: all of text, from 1 to maxThreads
+bool parseThreadCount(std::string_view text, unsigned &threadCount)
 {
-    ltrim(name);
-    rtrim(name);
-    toLower(name);
+    unsigned parsed{};
+    auto [end, error]{ std::from_chars(text.data(), text.data() + text.size(), parsed) };
+    if (error != std::errc{} || end != text.data() + text.size() || parsed == 0 || parsed > maxThreads)
+        return false;
+    threadCount = parsed;
+    return true;
+}
+
+int runParallel(const char *path, unsigned threadCount)
+{
+    // a pipe or a terminal can't be mapped or split up front, so it gets the one-thread stream
+    if (!MappedFile::canMap(path))
+        return runBatch(path);
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
 
-    std::replace(name.begin(), name.end(), ' ', '_');
+    BatchStats stats{};
+    if (!normalize_file_parallel(path, stdout, threadCount, stats))
+    {
+        std::perror(path);
+        return 1;
+    }
+
+    report(stats, threadCount);
+    return 0;
 }
 
-int main()
+/* Usage:
+normalize_name                      prompts for a single name
+normalize_name --batch [file | -]   normalizes every line of file (or stdin)
+normalize_name --parallel file [n]  same, for a file, on n threads (default: all cores);
+                                    a pipe or other non-regular file falls back to --batch */
+
+int main(int argc, char *argv[])
 {
+    if (argc > 1 && std::strcmp(argv[1], "--batch") == 0)
+        return runBatch(argc > 2 ? argv[2] : nullptr);
+
+    if (argc > 2 && std::strcmp(argv[1], "--parallel") == 0)
+    {
+        unsigned threadCount{ 0 }; // all cores
+        if (argc > 3 && !parseThreadCount(argv[3], threadCount))
+        {
+            std::cerr << "the thread count must be a whole number from 1 to " << maxThreads << ", not \"" << argv[3]
+                      << "\"\n";
+            return 1;
+        }
+        return runParallel(argv[2], threadCount);
+    }
+
     std::cout << "Insert string: ";
     std::string name;
     std::getline(std::cin, name);
@@ -46,4 +354,4 @@ int main()
     std::cout << name << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,106 @@
+#ifndef NORMALIZE_NAME_H
+#define NORMALIZE_NAME_H
+
+#include "normalize_name_simd.h"
+#include "normalize_name_tables.h"
+#include "normalize_name_utf8.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// trim from start (in place)
+inline void ltrim(std::string &s) {
+    const char *data{ s.data() };
+    s.erase(0, static_cast<std::size_t>(skipSpace(data, data + s.size()) - data));
+}
+
+// trim from end (in place)
+inline void rtrim(std::string &s) {
+    const char *data{ s.data() };
+    s.resize(static_cast<std::size_t>(skipSpaceBack(data, data + s.size()) - data));
+}
+
+inline void toLower(std::string &name)
+{
+    lowerReplace(name.data(), name.size(), name.data(), ' ', ' ');
+}
+
+/* Fused ASCII normalization: trims both ends, lowercases and replaces ' ' with '_'
+in a single pass over name, writing the result to out. Nothing is allocated.
+out must have room for name.size() chars and may point at name.data() itself
+(the output never gets ahead of the input). Returns the number of chars written.
+Bytes above 0x7F are copied through untouched. */
+inline std::size_t normalize_name_ascii(std::string_view name, char *out)
+{
+    const char *first{ skipSpace(name.data(), name.data() + name.size()) };
+    const char *last{ skipSpaceBack(first, name.data() + name.size()) };
+
+    std::size_t count{ static_cast<std::size_t>(last - first) };
+    lowerReplace(first, count, out, ' ', '_');
+
+    return count;
+}
+
+/* Same as normalize_name_ascii for ASCII input, which takes the SIMD path
+unchanged after a vectorized check. Anything else is treated as UTF-8: Unicode
+whitespace is trimmed and every code point is lowercased (normalize_name_utf8.h). */
+inline std::size_t normalize_name(std::string_view name, char *out)
+{
+    const char *first{ skipSpace(name.data(), name.data() + name.size()) };
+    const char *last{ skipSpaceBack(first, name.data() + name.size()) };
+    std::size_t count{ static_cast<std::size_t>(last - first) };
+
+    // the ASCII trim stops at any byte above 0x7F, so only [first, last) needs checking
+    bool inPlace{ out < name.data() + name.size() && name.data() < out + name.size() };
+    if (inPlace)
+    {
+        // the ASCII kernel would destroy the input, so look before writing
+        if (!isAscii(first, last))
+            return normalize_name_utf8(name, out);
+        lowerReplace(first, count, out, ' ', '_');
+        return count;
+    }
+
+    // otherwise the kernel checks as it goes, and the rare UTF-8 name is redone
+    if (lowerReplace(first, count, out, ' ', '_'))
+        return count;
+    return normalize_name_utf8(name, out);
+}
+
+/* Same as normalize_name_ascii, but with the character classes and separator of
+Policy (see normalize_name_tables.h). Policies other than AsciiNamePolicy run the
+branch-free table loop; AsciiNamePolicy goes to the SIMD kernels. */
+template <typename Policy>
+std::size_t normalize_name(std::string_view name, char *out)
+{
+    if constexpr (std::is_same_v<Policy, AsciiNamePolicy>)
+    {
+        return normalize_name_ascii(name, out);
+    }
+    else
+    {
+        using Tables = NameTables<Policy>;
+
+        const unsigned char *first{ reinterpret_cast<const unsigned char *>(name.data()) };
+        const unsigned char *last{ first + name.size() };
+        while (first != last && Tables::space[*first])
+            ++first;
+        while (last != first && Tables::space[last[-1]])
+            --last;
+
+        std::size_t count{ static_cast<std::size_t>(last - first) };
+        for (std::size_t i{ 0 }; i < count; ++i)
+            out[i] = static_cast<char>(Tables::fold[first[i]]);
+
+        return count;
+    }
+}
+
+// in-place wrapper over the fused kernel
+inline void normalize_name(std::string &name)
+{
+    name.resize(normalize_name(name, name.data()));
+}
+
+#endif
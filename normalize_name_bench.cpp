@@ -0,0 +1,578 @@
+/* Benchmarks for the normalize_name family.
+
+Build with optimizations, e.g.
+g++ -std=c++20 -O2 -pthread normalize_name_bench.cpp -o normalize_name_bench
+
+Usage:
+normalize_name_bench              prints a table for every benchmark
+normalize_name_bench --csv file   also writes every measurement to file as CSV,
+                                  one row per benchmark, so builds can be diffed */
+
+#include "allocation_counter.h"
+#include "normalize_name.h"
+#include "normalize_name_cache.h"
+#include "normalize_names.h"
+#include "normalize_pipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+// keeps the optimizer from throwing away results we never look at
+template <typename T>
+void doNotOptimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+/* Cycle estimate
+
+bytes/cycle needs the core clock, which neither std::chrono nor (portably) the
+hardware counters give us. A chain of dependent adds runs at one add per cycle on
+every CPU this targets, so timing one gives cycles per nanosecond. */
+double measureCyclesPerNs()
+{
+    constexpr std::uint64_t adds{ 200'000'000 };
+    std::uint64_t x{ 0 };
+
+    auto start{ std::chrono::steady_clock::now() };
+    for (std::uint64_t i{ 0 }; i < adds; ++i)
+    {
+        x += i;
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : "+r"(x)); // keeps the chain from being vectorized or folded
+#endif
+    }
+    auto elapsed{ std::chrono::steady_clock::now() - start };
+    doNotOptimize(x);
+
+    return adds / std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+static double g_cyclesPerNs{ 1.0 };
+
+struct Measurement
+{
+    double nsPerName{};
+    double allocationsPerName{};
+    double nsPerByte{};
+    double bytesPerCycle{};
+};
+
+/* runs body rounds times over nameCount names (byteCount bytes of input) and
+reports the average cost per name and per byte */
+template <typename Body>
+Measurement measure(std::size_t nameCount, std::size_t byteCount, int rounds, Body body)
+{
+    body(); // warm up caches and any memory the body keeps around
+
+    std::size_t allocationsBefore{ allocationCount() };
+    auto start{ std::chrono::steady_clock::now() };
+    for (int i{ 0 }; i < rounds; ++i)
+        body();
+    double ns{ std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+
+    double names{ static_cast<double>(nameCount) * rounds };
+    double bytes{ static_cast<double>(byteCount) * rounds };
+    return { ns / names,
+             static_cast<double>(allocationCount() - allocationsBefore) / names,
+             bytes > 0 ? ns / bytes : 0.0,
+             ns > 0 ? bytes / (ns * g_cyclesPerNs) : 0.0 };
+}
+
+// every measurement, for the CSV file
+struct Result
+{
+    std::string section;
+    std::string name;
+    std::string input;
+    std::string path;
+    Measurement m;
+};
+
+static std::vector<Result> g_results;
+static std::string g_section;
+
+void print(const char *name, Measurement m, const char *input = "mixed")
+{
+    std::printf("%-32s %8.2f ns/name %8.3f ns/byte %6.2f bytes/cycle %8.3f allocs/name\n",
+                name, m.nsPerName, m.nsPerByte, m.bytesPerCycle, m.allocationsPerName);
+    g_results.push_back({ g_section, name, input, simdPathName(activeSimdPath()), m });
+}
+
+std::size_t totalSize(const std::vector<std::string> &names)
+{
+    std::size_t total{ 0 };
+    for (const std::string &name : names)
+        total += name.size();
+    return total;
+}
+
+// padded, mixed-case names; every eighth one is long enough to defeat the small string optimization
+std::vector<std::string> makeNames(std::size_t count)
+{
+    std::mt19937 rng{ 12345 };
+    const char letters[]{ "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ     " };
+
+    std::vector<std::string> names(count);
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        std::size_t length{ (i % 8 == 0) ? 40 + rng() % 80 : 4 + rng() % 12 };
+        std::string &name{ names[i] };
+        name.append(rng() % 4, ' ');
+        for (std::size_t j{ 0 }; j < length; ++j)
+            name.push_back(letters[rng() % (sizeof(letters) - 1)]);
+        name.append(rng() % 4, '\t');
+    }
+    return names;
+}
+
+void benchBatch(const std::vector<std::string> &names)
+{
+    g_section = "batch";
+    std::printf("\nBatch API, %zu names\n", names.size());
+    constexpr int rounds{ 20 };
+    std::size_t bytes{ totalSize(names) };
+
+    std::vector<std::string_view> views(names.begin(), names.end());
+
+    std::vector<std::string> copies;
+    copies.reserve(names.size());
+    print("std::string per name", measure(names.size(), bytes, rounds, [&] {
+        copies.clear();
+        for (const std::string &name : names)
+        {
+            copies.push_back(name);
+            normalize_name(copies.back());
+        }
+        doNotOptimize(copies.data());
+    }));
+
+    NameArena arena;
+    print("normalize_names + arena", measure(names.size(), bytes, rounds, [&] {
+        arena.reset();
+        std::span<const std::string_view> results{ normalize_names(views, arena) };
+        doNotOptimize(results.data());
+    }));
+    std::printf("  arena holds %zu bytes in %zu blocks\n", arena.bytesReserved(), arena.blockAllocations());
+}
+
+using FeedPipeline = NamePipeline<Trim, StripPunct, CollapseSpace, Lowercase, ReplaceSpace<'-'>>;
+
+// what FeedPipeline does, written out by hand
+std::size_t normalizeFeedByHand(std::string_view name, char *out)
+{
+    std::size_t first{ 0 };
+    std::size_t last{ name.size() };
+    while (first < last && AsciiNamePolicy::isSpace(static_cast<unsigned char>(name[first])))
+        ++first;
+    while (last > first && AsciiNamePolicy::isSpace(static_cast<unsigned char>(name[last - 1])))
+        --last;
+
+    char *dest{ out };
+    bool inGap{ false };
+    for (std::size_t i{ first }; i < last; ++i)
+    {
+        auto ch{ static_cast<unsigned char>(name[i]) };
+        if (isAsciiPunct(ch))
+            continue;
+        if (AsciiNamePolicy::isSpace(ch))
+        {
+            inGap = dest != out; // a gap before the first kept char is leading whitespace
+            continue;
+        }
+        if (inGap)
+        {
+            *dest++ = '-';
+            inGap = false;
+        }
+        *dest++ = static_cast<char>(AsciiNamePolicy::toLower(ch));
+    }
+    return static_cast<std::size_t>(dest - out);
+}
+
+// the feed pipeline and the hand-written feed on inputs where stripping uncovers whitespace at the ends
+bool checkFeed()
+{
+    struct Case
+    {
+        std::string_view name;
+        std::string_view expected;
+    };
+    constexpr Case cases[]{
+        { ". John Smith .", "john-smith" },
+        { "  'Ann'  O'Neil ,\t", "ann-oneil" },
+        { "...", "" },
+        { "Mary-Jane", "maryjane" },
+    };
+
+    bool ok{ true };
+    char out[64];
+    for (const Case &check : cases)
+    {
+        std::string_view byPipeline{ out, FeedPipeline::run(check.name, out) };
+        ok = ok && byPipeline == check.expected;
+        std::string_view byHand{ out, normalizeFeedByHand(check.name, out) };
+        ok = ok && byHand == check.expected;
+    }
+    return ok;
+}
+
+template <typename Normalize>
+Measurement measureKernel(const std::vector<std::string> &names, std::vector<char> &out, Normalize normalize)
+{
+    return measure(names.size(), totalSize(names), 20, [&] {
+        char *dest{ out.data() };
+        for (const std::string &name : names)
+            dest += normalize(name, dest);
+        doNotOptimize(dest);
+    });
+}
+
+void benchPipeline(const std::vector<std::string> &names)
+{
+    g_section = "pipeline";
+    std::printf("\nPipeline vs hand-written, %zu names\n", names.size());
+
+    std::vector<char> out(totalSize(names));
+
+    print("normalize_name_ascii", measureKernel(names, out, normalize_name_ascii));
+    print("normalize_name (UTF-8 aware)", measureKernel(names, out, [](std::string_view name, char *dest) {
+        return normalize_name(name, dest);
+    }));
+    print("DefaultNamePipeline", measureKernel(names, out, DefaultNamePipeline::run));
+    print("hand-written feed", measureKernel(names, out, normalizeFeedByHand));
+    print("FeedPipeline", measureKernel(names, out, FeedPipeline::run));
+}
+
+void benchCache(const std::vector<std::string> &names)
+{
+    constexpr std::size_t lookups{ 2'000'000 };
+    constexpr std::size_t distinct{ 50'000 };
+    g_section = "cache";
+    std::printf("\nInterning cache, %zu lookups over %zu distinct names\n", lookups, distinct);
+
+    // skewed towards the front, so some names are far more common than others;
+    // laid out back to back like the lines of an input file
+    std::mt19937 rng{ 777 };
+    std::string text;
+    std::vector<std::size_t> offsets(lookups + 1);
+    for (std::size_t i{ 0 }; i < lookups; ++i)
+    {
+        std::size_t a{ rng() % distinct };
+        std::size_t b{ rng() % distinct };
+        offsets[i] = text.size();
+        text += names[a < b ? a : b];
+    }
+    offsets[lookups] = text.size();
+
+    std::vector<std::string_view> stream(lookups);
+    for (std::size_t i{ 0 }; i < lookups; ++i)
+        stream[i] = std::string_view(text).substr(offsets[i], offsets[i + 1] - offsets[i]);
+
+    print("new std::string per name", measure(lookups, text.size(), 5, [&] {
+        for (std::string_view name : stream)
+        {
+            std::string result{ name };
+            normalize_name(result);
+            doNotOptimize(result.data());
+        }
+    }));
+
+    NameCache cache{ distinct };
+    print("NameCache (fits everything)", measure(lookups, text.size(), 5, [&] {
+        for (std::string_view name : stream)
+            doNotOptimize(cache.intern(name).data());
+    }));
+
+    NameCache smallCache{ distinct / 8 };
+    print("NameCache (1/8 of the names)", measure(lookups, text.size(), 5, [&] {
+        for (std::string_view name : stream)
+            doNotOptimize(smallCache.intern(name).data());
+    }));
+
+    for (const NameCache *c : { &cache, &smallCache })
+    {
+        const NameCache::Stats &stats{ c->stats() };
+        std::printf("  %6zu entries: %zu hits, %zu misses, %zu evictions (%.1f%% hit rate)\n",
+                    c->capacity(), stats.hits, stats.misses, stats.evictions,
+                    100.0 * stats.hits / (stats.hits + stats.misses));
+    }
+}
+
+/* Per-function suite
+
+Every function runs over each kind of input below, once per SIMD path the CPU
+supports. The in-place std::string functions start each call with an assign()
+into a reused string, which never allocates but is included in their time.
+
+Before anything is timed, every path's output is compared with the scalar
+path's, on the same inputs and on names built to put the edge between
+whitespace and text at every offset of a vector. A difference stops the run. */
+
+struct InputSet
+{
+    const char *name;
+    std::vector<std::string> names;
+};
+
+std::vector<InputSet> makeInputSets(std::size_t count)
+{
+    std::mt19937 rng{ 2024 };
+    auto pick = [&](std::string_view chars) { return chars[rng() % chars.size()]; };
+    const std::string_view lower{ "abcdefghijklmnopqrstuvwxyz" };
+    const std::string_view mixed{ "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ " };
+    const std::string_view space{ " \t\r\n\v\f" };
+    const std::string_view utf8[]{ "\u00C9", "\u00E9", "\u00DF", "\u0391", "\u03C9", "\u0416",
+                                   "\u0436", "\u4E2D", "\uFF21", "\u00A0", "a", "B", " " };
+
+    std::vector<InputSet> sets{ { "short", {} }, { "long", {} }, { "padded", {} },
+                                { "whitespace", {} }, { "mixed-case", {} }, { "utf8", {} } };
+    for (InputSet &set : sets)
+        set.names.resize(count);
+
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        for (std::size_t j{ 0 }, n{ 4 + rng() % 9 }; j < n; ++j)
+            sets[0].names[i].push_back(pick(lower));
+
+        for (std::size_t j{ 0 }, n{ 200 + rng() % 200 }; j < n; ++j)
+            sets[1].names[i].push_back(pick(mixed));
+
+        sets[2].names[i].append(32 + rng() % 64, ' ');
+        for (std::size_t j{ 0 }, n{ 8 + rng() % 8 }; j < n; ++j)
+            sets[2].names[i].push_back(pick(mixed));
+        sets[2].names[i].append(32 + rng() % 64, '\t');
+
+        for (std::size_t j{ 0 }, n{ 16 + rng() % 32 }; j < n; ++j)
+            sets[3].names[i].push_back(pick(space));
+
+        for (std::size_t j{ 0 }, n{ 16 + rng() % 16 }; j < n; ++j)
+            sets[4].names[i].push_back(pick(mixed));
+
+        sets[5].names[i] = "\u00A0";
+        for (std::size_t j{ 0 }, n{ 8 + rng() % 16 }; j < n; ++j)
+            sets[5].names[i] += utf8[rng() % std::size(utf8)];
+        sets[5].names[i] += "\u3000";
+    }
+    return sets;
+}
+
+template <typename Function>
+void measureInPlace(const char *name, const InputSet &set, Function function)
+{
+    std::size_t bytes{ totalSize(set.names) };
+    int rounds{ static_cast<int>(std::max<std::size_t>(1, (16u << 20) / bytes)) };
+
+    std::string scratch;
+    scratch.reserve(1024);
+    print(name, measure(set.names.size(), bytes, rounds, [&] {
+        for (const std::string &input : set.names)
+        {
+            scratch.assign(input);
+            function(scratch);
+            doNotOptimize(scratch.data());
+        }
+    }), set.name);
+}
+
+template <typename Function>
+void measureInto(const char *name, const InputSet &set, std::vector<char> &out, Function function)
+{
+    std::size_t bytes{ totalSize(set.names) };
+    int rounds{ static_cast<int>(std::max<std::size_t>(1, (16u << 20) / bytes)) };
+
+    print(name, measure(set.names.size(), bytes, rounds, [&] {
+        char *dest{ out.data() };
+        for (const std::string &input : set.names)
+            dest += function(input, dest);
+        doNotOptimize(dest);
+    }), set.name);
+}
+
+/* Runs of ASCII and Unicode whitespace of every length up to a few vectors,
+before, after, around and inside ASCII, non-ASCII and malformed UTF-8 text. */
+std::vector<std::string> makeEdgeNames()
+{
+    const std::string_view spaces[]{ " ", "\t", "\n\v\f\r", "\u00A0", "\u3000" };
+    const std::string_view texts[]{ "", "A", "Ab C", "\u00C9t\u00E9", "x\xC3", "\xFF" };
+
+    std::vector<std::string> names;
+    for (std::size_t length{ 0 }; length <= 70; ++length)
+    {
+        for (std::string_view space : spaces)
+        {
+            std::string run;
+            for (std::size_t i{ 0 }; i < length; ++i)
+                run += space;
+
+            names.push_back("A" + run + "b");
+            for (std::string_view text : texts)
+            {
+                names.push_back(run + std::string{ text });
+                names.push_back(std::string{ text } + run);
+                names.push_back(run + std::string{ text } + run);
+            }
+        }
+    }
+    return names;
+}
+
+// every suite function on every input, each path against scalar; reports the first few differences
+bool checkSuite(const std::vector<InputSet> &sets, const std::vector<SimdPath> &paths)
+{
+    SimdPath before{ activeSimdPath() };
+    std::size_t differences{ 0 };
+
+    auto compare = [&](const char *function, auto run) {
+        for (const InputSet &set : sets)
+        {
+            for (std::size_t i{ 0 }; i < set.names.size(); ++i)
+            {
+                forceSimdPath(SimdPath::scalar);
+                std::string expected{ run(set.names[i]) };
+                for (SimdPath path : paths)
+                {
+                    forceSimdPath(path);
+                    if (run(set.names[i]) != expected && ++differences <= 10)
+                        std::fprintf(stderr, "%s differs from scalar on the %s path, %s input %zu\n", function,
+                                     simdPathName(path), set.name, i);
+                }
+            }
+        }
+    };
+    auto inPlace = [](auto function) {
+        return [function](const std::string &input) {
+            std::string s{ input };
+            function(s);
+            return s;
+        };
+    };
+    auto into = [](auto function) {
+        return [function](const std::string &input) {
+            std::string s(input.size(), '\0');
+            s.resize(function(input, s.data()));
+            return s;
+        };
+    };
+
+    compare("ltrim", inPlace([](std::string &s) { ltrim(s); }));
+    compare("rtrim", inPlace([](std::string &s) { rtrim(s); }));
+    compare("toLower", inPlace([](std::string &s) { toLower(s); }));
+    compare("normalize_name (in place)", inPlace([](std::string &s) { normalize_name(s); }));
+    compare("normalize_name (fused)", into([](std::string_view name, char *dest) { return normalize_name(name, dest); }));
+    compare("normalize_name_ascii", into(normalize_name_ascii));
+    compare("normalize_name_utf8", into(normalize_name_utf8));
+    compare("DefaultNamePipeline", into(DefaultNamePipeline::run));
+
+    forceSimdPath(before);
+    if (differences > 10)
+        std::fprintf(stderr, "... and %zu more\n", differences - 10);
+    return differences == 0;
+}
+
+// false if a path gave different output from the scalar one, in which case nothing is timed
+bool benchSuite()
+{
+    g_section = "suite";
+    std::vector<InputSet> sets{ makeInputSets(20'000) };
+
+    SimdPath best{ detectSimdPath() };
+    std::vector<SimdPath> paths{ SimdPath::scalar };
+    if (best == SimdPath::avx2)
+        paths.push_back(SimdPath::sse2);
+    if (best != SimdPath::scalar)
+        paths.push_back(best);
+
+    std::vector<InputSet> checked{ sets };
+    checked.push_back({ "whitespace-edge", makeEdgeNames() });
+    if (!checkSuite(checked, paths))
+        return false;
+
+    for (SimdPath path : paths)
+    {
+        forceSimdPath(path);
+        for (const InputSet &set : sets)
+        {
+            std::printf("\nSuite, %s input, %s path\n", set.name, simdPathName(path));
+            std::vector<char> out(totalSize(set.names));
+
+            measureInPlace("ltrim", set, [](std::string &s) { ltrim(s); });
+            measureInPlace("rtrim", set, [](std::string &s) { rtrim(s); });
+            measureInPlace("toLower", set, [](std::string &s) { toLower(s); });
+            measureInPlace("normalize_name (in place)", set, [](std::string &s) { normalize_name(s); });
+            measureInto("normalize_name (fused)", set, out, [](std::string_view name, char *dest) {
+                return normalize_name(name, dest);
+            });
+            measureInto("normalize_name_ascii", set, out, normalize_name_ascii);
+            measureInto("normalize_name_utf8", set, out, normalize_name_utf8);
+            measureInto("DefaultNamePipeline", set, out, DefaultNamePipeline::run);
+        }
+    }
+    forceSimdPath(best);
+    return true;
+}
+
+// one row per measurement; the header names every column
+bool writeCsv(const char *path)
+{
+    std::FILE *file{ std::fopen(path, "w") };
+    if (!file)
+        return false;
+
+    std::fprintf(file, "section,benchmark,input,simd_path,ns_per_call,ns_per_byte,bytes_per_cycle,allocs_per_call\n");
+    for (const Result &r : g_results)
+    {
+        std::fprintf(file, "%s,\"%s\",%s,%s,%.3f,%.4f,%.4f,%.4f\n", r.section.c_str(), r.name.c_str(),
+                     r.input.c_str(), r.path.c_str(), r.m.nsPerName, r.m.nsPerByte, r.m.bytesPerCycle,
+                     r.m.allocationsPerName);
+    }
+    return std::fclose(file) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *csvPath{ nullptr };
+    if (argc > 2 && std::strcmp(argv[1], "--csv") == 0)
+        csvPath = argv[2];
+
+    g_cyclesPerNs = measureCyclesPerNs();
+    std::printf("SIMD path: %s, about %.2f GHz\n", simdPathName(activeSimdPath()), g_cyclesPerNs);
+
+    if (!checkFeed())
+    {
+        std::fprintf(stderr, "FeedPipeline or the hand-written feed gave a wrong result!\n");
+        return 1;
+    }
+
+    if (!benchSuite())
+    {
+        std::fprintf(stderr, "a SIMD path gave different output from the scalar path!\n");
+        return 1;
+    }
+
+    std::vector<std::string> names{ makeNames(1'000'000) };
+    benchBatch(names);
+    benchPipeline(names);
+    benchCache(names);
+
+    if (csvPath && !writeCsv(csvPath))
+    {
+        std::perror(csvPath);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+#ifndef NORMALIZE_NAME_CACHE_H
+#define NORMALIZE_NAME_CACHE_H
+
+/* Interning cache for normalized names.
+
+Most input streams repeat the same names over and over. NameCache remembers the
+normalized form of up to maxEntries raw names, so a repeat costs one hash and a
+short probe instead of a normalize and an allocation.
+
+The index is an open-addressing table with linear probing, twice the size of the
+entry pool. Each slot holds the entry number and 32 bits of its hash, so most
+probes never touch an entry. Entries are one cache line each and keep short
+names inline, so a hit on a short name touches two cache lines. When the pool is full the CLOCK algorithm picks the
+victim: a hit sets an entry's referenced bit, and the clock hand evicts the first
+entry it finds without one (clearing bits as it passes). Removal from the index
+shifts later slots back instead of leaving tombstones. */
+
+#include "normalize_name.h"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// fast non-cryptographic 64-bit hash, 8 bytes per step
+inline std::uint64_t hashName(std::string_view name)
+{
+    constexpr std::uint64_t k{ 0x9E3779B97F4A7C15u };
+    std::uint64_t h{ name.size() * k };
+
+    const char *p{ name.data() };
+    std::size_t count{ name.size() };
+    for (; count >= 8; p += 8, count -= 8)
+    {
+        std::uint64_t word{};
+        std::memcpy(&word, p, sizeof(word));
+        h = (h ^ (word * k)) * 0xBF58476D1CE4E5B9u;
+        h ^= h >> 31;
+    }
+    if (count)
+    {
+        std::uint64_t word{ 0 };
+        std::memcpy(&word, p, count);
+        h = (h ^ (word * k)) * 0xBF58476D1CE4E5B9u;
+    }
+
+    h ^= h >> 32;
+    h *= 0x94D049BB133111EBu;
+    return h ^ (h >> 29);
+}
+
+class NameCache
+{
+public:
+    struct Stats
+    {
+        std::size_t hits{};
+        std::size_t misses{};
+        std::size_t evictions{};
+        std::size_t uncached{}; // names longer than maxNameLength
+    };
+
+    /* Holds at most maxEntries names of up to maxNameLength bytes each, so its
+    memory is bounded by roughly maxEntries * (2 * maxNameLength + 64) bytes. */
+    explicit NameCache(std::size_t maxEntries = 1 << 16, std::size_t maxNameLength = 256)
+        : m_entries(maxEntries ? maxEntries : 1),
+          m_slots(std::bit_ceil(m_entries.size() * 2)),
+          m_maxNameLength{ maxNameLength }
+    {
+    }
+
+    NameCache(const NameCache &) = delete;
+    NameCache &operator=(const NameCache &) = delete;
+
+    /* Returns the normalized form of raw. The view stays valid until raw's entry
+    is evicted, which takes at least maxEntries - 1 further misses. Names longer
+    than maxNameLength are normalized into a scratch buffer that the next call
+    reuses. */
+    std::string_view intern(std::string_view raw)
+    {
+        if (raw.size() > m_maxNameLength)
+        {
+            ++m_stats.uncached;
+            m_scratch.resize(raw.size());
+            m_scratch.resize(normalize_name(raw, m_scratch.data()));
+            return m_scratch;
+        }
+
+        std::uint64_t hash{ hashName(raw) };
+        auto tag{ static_cast<std::uint32_t>(hash >> 32) };
+        std::size_t mask{ m_slots.size() - 1 };
+
+        std::size_t slot{ hash & mask };
+        for (; m_slots[slot].entry != 0; slot = (slot + 1) & mask)
+        {
+            if (m_slots[slot].tag != tag)
+                continue;
+
+            Entry &entry{ m_entries[m_slots[slot].entry - 1] };
+            if (entry.rawSize == raw.size() && std::memcmp(entry.text(), raw.data(), raw.size()) == 0)
+            {
+                ++m_stats.hits;
+                entry.referenced = true;
+                return normalizedView(entry);
+            }
+        }
+
+        ++m_stats.misses;
+        std::uint32_t index{ takeEntry() };
+
+        // an eviction may have shifted slots around, so find the first empty one again
+        slot = hash & mask;
+        while (m_slots[slot].entry != 0)
+            slot = (slot + 1) & mask;
+
+        Entry &entry{ m_entries[index] };
+        char *text{ entry.reserve(raw.size() * 2) };
+        std::memcpy(text, raw.data(), raw.size());
+        entry.normalizedSize = static_cast<std::uint32_t>(normalize_name(raw, text + raw.size()));
+        entry.rawSize = static_cast<std::uint32_t>(raw.size());
+        entry.hash = hash;
+        entry.referenced = false;
+
+        m_slots[slot] = { index + 1, tag };
+        return normalizedView(entry);
+    }
+
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = {}; }
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_entries.size(); }
+
+private:
+    // the raw name followed by its normalized form, inline when they fit
+    struct alignas(64) Entry
+    {
+        std::uint64_t hash{};
+        std::unique_ptr<char[]> heap;
+        std::uint32_t heapSize{};
+        std::uint32_t rawSize{};
+        std::uint32_t normalizedSize{};
+        bool referenced{};
+        char local[64 - 29]{};
+
+        const char *text() const { return rawSize * 2 <= sizeof(local) ? local : heap.get(); }
+
+        // room for size chars; keeps the heap buffer of an evicted name for reuse
+        char *reserve(std::size_t size)
+        {
+            if (size <= sizeof(local))
+                return local;
+            if (size > heapSize)
+            {
+                heap.reset(new char[size]);
+                heapSize = static_cast<std::uint32_t>(size);
+            }
+            return heap.get();
+        }
+    };
+    static_assert(sizeof(Entry) == 64);
+
+    struct Slot
+    {
+        std::uint32_t entry{}; // index into m_entries plus one, 0 for an empty slot
+        std::uint32_t tag{};   // upper half of the entry's hash
+    };
+
+    static std::string_view normalizedView(const Entry &entry)
+    {
+        return { entry.text() + entry.rawSize, entry.normalizedSize };
+    }
+
+    // a free entry, evicting one with the clock hand once the pool is full
+    std::uint32_t takeEntry()
+    {
+        if (m_size < m_entries.size())
+            return static_cast<std::uint32_t>(m_size++);
+
+        while (true)
+        {
+            Entry &entry{ m_entries[m_hand] };
+            auto index{ static_cast<std::uint32_t>(m_hand) };
+            m_hand = (m_hand + 1) % m_entries.size();
+
+            if (entry.referenced)
+            {
+                entry.referenced = false;
+                continue;
+            }
+
+            removeFromIndex(index);
+            ++m_stats.evictions;
+            return index;
+        }
+    }
+
+    // backward-shift deletion: keeps every probe sequence unbroken without tombstones
+    void removeFromIndex(std::uint32_t index)
+    {
+        std::size_t mask{ m_slots.size() - 1 };
+        std::size_t hole{ m_entries[index].hash & mask };
+        while (m_slots[hole].entry != index + 1)
+            hole = (hole + 1) & mask;
+
+        std::size_t next{ (hole + 1) & mask };
+        while (m_slots[next].entry != 0)
+        {
+            std::size_t home{ m_entries[m_slots[next].entry - 1].hash & mask };
+            // move next into the hole unless its home lies cyclically in (hole, next]
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                m_slots[hole] = m_slots[next];
+                hole = next;
+            }
+            next = (next + 1) & mask;
+        }
+        m_slots[hole] = {};
+    }
+
+    std::vector<Entry> m_entries;
+    std::vector<Slot> m_slots;
+    std::size_t m_maxNameLength;
+    std::size_t m_size{ 0 };
+    std::size_t m_hand{ 0 };
+    Stats m_stats{};
+    std::string m_scratch;
+};
+
+#endif
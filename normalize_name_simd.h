@@ -0,0 +1,418 @@
+#ifndef NORMALIZE_NAME_SIMD_H
+#define NORMALIZE_NAME_SIMD_H
+
+/* Vectorized kernels behind normalize_name.
+
+Every kernel exists as a scalar loop and as 16/32-byte SIMD versions (SSE2 and
+AVX2 on x86, NEON on ARM64). The scalar loops look bytes up in AsciiNameTables;
+the SIMD versions compare against the same classes (whitespace is ' ' and
+'\t'..'\r', uppercase is 'A'..'Z'), so every path produces byte-identical
+output. The path is picked once at runtime from the CPU's features (see
+cpu_features.h). */
+
+#include "cpu_features.h"
+#include "normalize_name_tables.h"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+enum class SimdPath
+{
+    scalar,
+    sse2,
+    avx2,
+    neon,
+};
+
+inline const char *simdPathName(SimdPath path)
+{
+    switch (path)
+    {
+    case SimdPath::sse2: return "sse2";
+    case SimdPath::avx2: return "avx2";
+    case SimdPath::neon: return "neon";
+    default:             return "scalar";
+    }
+}
+
+// the widest path this CPU (and OS) can run
+inline SimdPath detectSimdPath()
+{
+    const CpuFeatures &cpu{ cpuFeatures() };
+    if (cpu.avx2)
+        return SimdPath::avx2;
+    if (cpu.sse2)
+        return SimdPath::sse2;
+    if (cpu.neon)
+        return SimdPath::neon;
+    return SimdPath::scalar;
+}
+
+/* Detected while the program starts up, so the kernels below only pay for a plain
+load. Anything that runs before that sees zero, which is the scalar path. */
+inline SimdPath g_simdPath{ detectSimdPath() };
+
+inline SimdPath activeSimdPath()
+{
+    return g_simdPath;
+}
+
+/* Forces a narrower path, e.g. to compare paths against each other. Requests for
+a path the CPU can't run (or a different ISA family) fall back to scalar. */
+inline void forceSimdPath(SimdPath path)
+{
+    SimdPath best{ detectSimdPath() };
+    bool supported{ path == SimdPath::scalar || path == best ||
+                    (path == SimdPath::sse2 && best == SimdPath::avx2) };
+    g_simdPath = supported ? path : SimdPath::scalar;
+}
+
+
+/* Scalar kernels */
+
+// first char in [first, last) that isn't whitespace, or last
+inline const char *skipSpaceScalar(const char *first, const char *last)
+{
+    while (first != last && AsciiNameTables::space[static_cast<unsigned char>(*first)])
+        ++first;
+    return first;
+}
+
+// one past the last char in [first, last) that isn't whitespace, or first
+inline const char *skipSpaceBackScalar(const char *first, const char *last)
+{
+    while (last != first && AsciiNameTables::space[static_cast<unsigned char>(last[-1])])
+        --last;
+    return last;
+}
+
+/* Lowercases count chars of src into out and maps from to to afterwards.
+out may equal src, or lie before it (the output never gets ahead of the input).
+Returns true if every byte was ASCII, which comes for free with the loads. */
+inline bool lowerReplaceScalar(const char *src, std::size_t count, char *out, char from, char to)
+{
+    unsigned bits{ 0 };
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        auto byte{ static_cast<unsigned char>(src[i]) };
+        bits |= byte;
+        char ch{ static_cast<char>(AsciiNameTables::lower[byte]) };
+        out[i] = (ch == from) ? to : ch;
+    }
+    return bits < 0x80;
+}
+
+// true if no byte of [first, last) has its top bit set
+inline bool isAsciiScalar(const char *first, const char *last)
+{
+    std::uint64_t bits{ 0 };
+    for (; last - first >= 8; first += 8)
+    {
+        std::uint64_t word{};
+        std::memcpy(&word, first, sizeof(word));
+        bits |= word;
+    }
+    for (; first != last; ++first)
+        bits |= static_cast<unsigned char>(*first);
+    return (bits & 0x8080808080808080u) == 0;
+}
+
+
+#if defined(SIMD_X86)
+
+/* SSE2 kernels, 16 bytes per step */
+
+// 0xFF in every byte that is ' ' or '\t'..'\r'
+SIMD_TARGET("sse2")
+inline __m128i spaceMaskSse2(__m128i v)
+{
+    __m128i controls = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+                                     _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1)));
+    return _mm_or_si128(controls, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+}
+
+SIMD_TARGET("sse2")
+inline const char *skipSpaceSse2(const char *first, const char *last)
+{
+    while (last - first >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        unsigned nonSpace{ ~static_cast<unsigned>(_mm_movemask_epi8(spaceMaskSse2(v))) & 0xFFFFu };
+        if (nonSpace)
+            return first + std::countr_zero(nonSpace);
+        first += 16;
+    }
+    return skipSpaceScalar(first, last);
+}
+
+SIMD_TARGET("sse2")
+inline const char *skipSpaceBackSse2(const char *first, const char *last)
+{
+    while (last - first >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(last - 16));
+        unsigned nonSpace{ ~static_cast<unsigned>(_mm_movemask_epi8(spaceMaskSse2(v))) & 0xFFFFu };
+        if (nonSpace)
+            return last - 16 + (31 - std::countl_zero(nonSpace)) + 1;
+        last -= 16;
+    }
+    return skipSpaceBackScalar(first, last);
+}
+
+SIMD_TARGET("sse2")
+inline bool lowerReplaceSse2(const char *src, std::size_t count, char *out, char from, char to)
+{
+    const __m128i fromV = _mm_set1_epi8(from);
+    const __m128i toV = _mm_set1_epi8(to);
+    __m128i bits = _mm_setzero_si128();
+
+    std::size_t i{ 0 };
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        bits = _mm_or_si128(bits, v);
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+
+        __m128i hit = _mm_cmpeq_epi8(v, fromV);
+        v = _mm_or_si128(_mm_andnot_si128(hit, v), _mm_and_si128(hit, toV));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+    }
+    bool tail{ lowerReplaceScalar(src + i, count - i, out + i, from, to) };
+    return tail && _mm_movemask_epi8(bits) == 0;
+}
+
+SIMD_TARGET("sse2")
+inline bool isAsciiSse2(const char *first, const char *last)
+{
+    __m128i bits = _mm_setzero_si128();
+    for (; last - first >= 16; first += 16)
+        bits = _mm_or_si128(bits, _mm_loadu_si128(reinterpret_cast<const __m128i *>(first)));
+    return _mm_movemask_epi8(bits) == 0 && isAsciiScalar(first, last);
+}
+
+
+/* AVX2 kernels, 32 bytes per step */
+
+SIMD_TARGET("avx2")
+inline __m256i spaceMaskAvx2(__m256i v)
+{
+    __m256i controls = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v));
+    return _mm256_or_si256(controls, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+}
+
+SIMD_TARGET("avx2")
+inline const char *skipSpaceAvx2(const char *first, const char *last)
+{
+    while (last - first >= 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        auto nonSpace{ ~static_cast<std::uint32_t>(_mm256_movemask_epi8(spaceMaskAvx2(v))) };
+        if (nonSpace)
+            return first + std::countr_zero(nonSpace);
+        first += 32;
+    }
+    return skipSpaceSse2(first, last);
+}
+
+SIMD_TARGET("avx2")
+inline const char *skipSpaceBackAvx2(const char *first, const char *last)
+{
+    while (last - first >= 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(last - 32));
+        auto nonSpace{ ~static_cast<std::uint32_t>(_mm256_movemask_epi8(spaceMaskAvx2(v))) };
+        if (nonSpace)
+            return last - 32 + (31 - std::countl_zero(nonSpace)) + 1;
+        last -= 32;
+    }
+    return skipSpaceBackSse2(first, last);
+}
+
+SIMD_TARGET("avx2")
+inline bool lowerReplaceAvx2(const char *src, std::size_t count, char *out, char from, char to)
+{
+    const __m256i fromV = _mm256_set1_epi8(from);
+    const __m256i toV = _mm256_set1_epi8(to);
+    __m256i bits = _mm256_setzero_si256();
+
+    std::size_t i{ 0 };
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        bits = _mm256_or_si256(bits, v);
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+        v = _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+        v = _mm256_blendv_epi8(v, toV, _mm256_cmpeq_epi8(v, fromV));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), v);
+    }
+    bool tail{ lowerReplaceSse2(src + i, count - i, out + i, from, to) };
+    return tail && _mm256_movemask_epi8(bits) == 0;
+}
+
+SIMD_TARGET("avx2")
+inline bool isAsciiAvx2(const char *first, const char *last)
+{
+    __m256i bits = _mm256_setzero_si256();
+    for (; last - first >= 32; first += 32)
+        bits = _mm256_or_si256(bits, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first)));
+    return _mm256_movemask_epi8(bits) == 0 && isAsciiSse2(first, last);
+}
+
+#endif // SIMD_X86
+
+
+#if defined(SIMD_NEON)
+
+/* NEON kernels, 16 bytes per step */
+
+inline uint8x16_t spaceMaskNeon(uint8x16_t v)
+{
+    uint8x16_t controls = vcleq_u8(vsubq_u8(v, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t'));
+    return vorrq_u8(controls, vceqq_u8(v, vdupq_n_u8(' ')));
+}
+
+// NEON has no movemask: narrow each byte of the mask to 4 bits of a 64-bit word
+inline std::uint64_t nibbleMaskNeon(uint8x16_t mask)
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(mask), 4)), 0);
+}
+
+inline const char *skipSpaceNeon(const char *first, const char *last)
+{
+    while (last - first >= 16)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t *>(first));
+        std::uint64_t nonSpace{ ~nibbleMaskNeon(spaceMaskNeon(v)) };
+        if (nonSpace)
+            return first + std::countr_zero(nonSpace) / 4;
+        first += 16;
+    }
+    return skipSpaceScalar(first, last);
+}
+
+inline const char *skipSpaceBackNeon(const char *first, const char *last)
+{
+    while (last - first >= 16)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t *>(last - 16));
+        std::uint64_t nonSpace{ ~nibbleMaskNeon(spaceMaskNeon(v)) };
+        if (nonSpace)
+            return last - 16 + (63 - std::countl_zero(nonSpace)) / 4 + 1;
+        last -= 16;
+    }
+    return skipSpaceBackScalar(first, last);
+}
+
+inline bool lowerReplaceNeon(const char *src, std::size_t count, char *out, char from, char to)
+{
+    const uint8x16_t fromV = vdupq_n_u8(static_cast<std::uint8_t>(from));
+    const uint8x16_t toV = vdupq_n_u8(static_cast<std::uint8_t>(to));
+    uint8x16_t bits = vdupq_n_u8(0);
+
+    std::size_t i{ 0 };
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t *>(src + i));
+        bits = vorrq_u8(bits, v);
+        uint8x16_t upper = vcleq_u8(vsubq_u8(v, vdupq_n_u8('A')), vdupq_n_u8('Z' - 'A'));
+        v = vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20)));
+        v = vbslq_u8(vceqq_u8(v, fromV), toV, v);
+        vst1q_u8(reinterpret_cast<std::uint8_t *>(out + i), v);
+    }
+    bool tail{ lowerReplaceScalar(src + i, count - i, out + i, from, to) };
+    return tail && vmaxvq_u8(bits) < 0x80;
+}
+
+inline bool isAsciiNeon(const char *first, const char *last)
+{
+    uint8x16_t bits = vdupq_n_u8(0);
+    for (; last - first >= 16; first += 16)
+        bits = vorrq_u8(bits, vld1q_u8(reinterpret_cast<const std::uint8_t *>(first)));
+    return vmaxvq_u8(bits) < 0x80 && isAsciiScalar(first, last);
+}
+
+#endif // SIMD_NEON
+
+
+/* Dispatchers */
+
+inline const char *skipSpace(const char *first, const char *last)
+{
+    switch (activeSimdPath())
+    {
+#if defined(SIMD_X86)
+    case SimdPath::avx2: return skipSpaceAvx2(first, last);
+    case SimdPath::sse2: return skipSpaceSse2(first, last);
+#elif defined(SIMD_NEON)
+    case SimdPath::neon: return skipSpaceNeon(first, last);
+#endif
+    default:             return skipSpaceScalar(first, last);
+    }
+}
+
+inline const char *skipSpaceBack(const char *first, const char *last)
+{
+    switch (activeSimdPath())
+    {
+#if defined(SIMD_X86)
+    case SimdPath::avx2: return skipSpaceBackAvx2(first, last);
+    case SimdPath::sse2: return skipSpaceBackSse2(first, last);
+#elif defined(SIMD_NEON)
+    case SimdPath::neon: return skipSpaceBackNeon(first, last);
+#endif
+    default:             return skipSpaceBackScalar(first, last);
+    }
+}
+
+inline bool isAscii(const char *first, const char *last)
+{
+    // most names fit in a few words: OR them together (the last one may overlap)
+    std::size_t count{ static_cast<std::size_t>(last - first) };
+    if (count >= 8 && count <= 32)
+    {
+        std::uint64_t bits{ 0 };
+        for (std::size_t i{ 0 }; i + 8 < count; i += 8)
+        {
+            std::uint64_t word{};
+            std::memcpy(&word, first + i, sizeof(word));
+            bits |= word;
+        }
+        std::uint64_t word{};
+        std::memcpy(&word, last - 8, sizeof(word));
+        return ((bits | word) & 0x8080808080808080u) == 0;
+    }
+    if (count < 8)
+        return isAsciiScalar(first, last);
+
+    switch (activeSimdPath())
+    {
+#if defined(SIMD_X86)
+    case SimdPath::avx2: return isAsciiAvx2(first, last);
+    case SimdPath::sse2: return isAsciiSse2(first, last);
+#elif defined(SIMD_NEON)
+    case SimdPath::neon: return isAsciiNeon(first, last);
+#endif
+    default:             return isAsciiScalar(first, last);
+    }
+}
+
+inline bool lowerReplace(const char *src, std::size_t count, char *out, char from, char to)
+{
+    switch (activeSimdPath())
+    {
+#if defined(SIMD_X86)
+    case SimdPath::avx2: return lowerReplaceAvx2(src, count, out, from, to);
+    case SimdPath::sse2: return lowerReplaceSse2(src, count, out, from, to);
+#elif defined(SIMD_NEON)
+    case SimdPath::neon: return lowerReplaceNeon(src, count, out, from, to);
+#endif
+    default:             return lowerReplaceScalar(src, count, out, from, to);
+    }
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef NORMALIZE_NAME_TABLES_H
+#define NORMALIZE_NAME_TABLES_H
+
+/* Character class tables for normalize_name.
+
+std::isspace and std::tolower look at the current C locale on every call, so
+they can't be inlined well and their results depend on the host's LANG. Instead,
+each policy below describes its character classes with constexpr functions, and
+NameTables<Policy> turns them into 256-entry tables at compile time. The hot
+loops then do one table lookup per byte and no branches. */
+
+#include <array>
+#include <cstddef>
+
+// the classes of the "C" locale, which is what normalize_name has always used
+struct AsciiNamePolicy
+{
+    static constexpr bool isSpace(unsigned char ch)
+    {
+        return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    }
+
+    static constexpr unsigned char toLower(unsigned char ch)
+    {
+        return (ch >= 'A' && ch <= 'Z') ? static_cast<unsigned char>(ch + ('a' - 'A')) : ch;
+    }
+
+    static constexpr char separator{ ' ' };   // mapped to replacement after lowercasing
+    static constexpr char replacement{ '_' };
+};
+
+// same classes, but words are joined with '-'
+struct AsciiDashNamePolicy : AsciiNamePolicy
+{
+    static constexpr char replacement{ '-' };
+};
+
+template <typename Policy>
+struct NameTables
+{
+    // true for every byte that trimming removes
+    static constexpr std::array<bool, 256> space{ [] {
+        std::array<bool, 256> table{};
+        for (std::size_t ch{ 0 }; ch < table.size(); ++ch)
+            table[ch] = Policy::isSpace(static_cast<unsigned char>(ch));
+        return table;
+    }() };
+
+    // lowercase form of every byte
+    static constexpr std::array<unsigned char, 256> lower{ [] {
+        std::array<unsigned char, 256> table{};
+        for (std::size_t ch{ 0 }; ch < table.size(); ++ch)
+            table[ch] = Policy::toLower(static_cast<unsigned char>(ch));
+        return table;
+    }() };
+
+    // lowercase form of every byte, with the separator already replaced
+    static constexpr std::array<unsigned char, 256> fold{ [] {
+        std::array<unsigned char, 256> table{};
+        for (std::size_t ch{ 0 }; ch < table.size(); ++ch)
+        {
+            unsigned char lowered{ Policy::toLower(static_cast<unsigned char>(ch)) };
+            table[ch] = (lowered == static_cast<unsigned char>(Policy::separator))
+                            ? static_cast<unsigned char>(Policy::replacement)
+                            : lowered;
+        }
+        return table;
+    }() };
+};
+
+using AsciiNameTables = NameTables<AsciiNamePolicy>;
+
+static_assert(AsciiNameTables::space['\v'] && !AsciiNameTables::space[0x85]);
+static_assert(AsciiNameTables::fold['Q'] == 'q' && AsciiNameTables::fold[' '] == '_');
+static_assert(AsciiNameTables::lower[0xC9] == 0xC9); // bytes above 0x7F are left alone
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef NORMALIZE_NAME_UTF8_H
+#define NORMALIZE_NAME_UTF8_H
+
+/* UTF-8 support for normalize_name.
+
+Non-ASCII names are trimmed of Unicode whitespace (the White_Space property, e.g.
+U+00A0 NO-BREAK SPACE or U+3000 IDEOGRAPHIC SPACE) and lowercased with the simple
+Unicode case mappings. Bytes that aren't valid UTF-8 are copied through as they
+are. */
+
+#include "normalize_name_tables.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+/* Simple lowercase mappings above U+007F, generated from the Unicode 14.0 data
+in Python's unicodedata:
+
+    for cp in range(0x80, 0x110000):
+        lower = 'i' if cp == 0x130 else chr(cp).lower()
+        if len(lower) == 1 and ord(lower) != cp: ...
+
+Code points first, first + stride, ... (count of them) map to cp + delta.
+U+023A and U+023E are left out: their lowercase forms take 3 bytes instead of 2,
+and normalize_name promises never to make a name longer. */
+struct CaseRange
+{
+    char32_t first;
+    std::uint16_t count;
+    std::uint8_t stride;
+    std::int32_t delta;
+};
+
+inline constexpr CaseRange caseRanges[]{
+    { 0x00C0, 23, 1, 32 }, { 0x00D8, 7, 1, 32 }, { 0x0100, 24, 2, 1 },
+    { 0x0130, 1, 1, -199 }, { 0x0132, 3, 2, 1 }, { 0x0139, 8, 2, 1 },
+    { 0x014A, 23, 2, 1 }, { 0x0178, 1, 1, -121 }, { 0x0179, 3, 2, 1 },
+    { 0x0181, 1, 1, 210 }, { 0x0182, 2, 2, 1 }, { 0x0186, 1, 1, 206 },
+    { 0x0187, 1, 1, 1 }, { 0x0189, 2, 1, 205 }, { 0x018B, 1, 1, 1 },
+    { 0x018E, 1, 1, 79 }, { 0x018F, 1, 1, 202 }, { 0x0190, 1, 1, 203 },
+    { 0x0191, 1, 1, 1 }, { 0x0193, 1, 1, 205 }, { 0x0194, 1, 1, 207 },
+    { 0x0196, 1, 1, 211 }, { 0x0197, 1, 1, 209 }, { 0x0198, 1, 1, 1 },
+    { 0x019C, 1, 1, 211 }, { 0x019D, 1, 1, 213 }, { 0x019F, 1, 1, 214 },
+    { 0x01A0, 3, 2, 1 }, { 0x01A6, 1, 1, 218 }, { 0x01A7, 1, 1, 1 },
+    { 0x01A9, 1, 1, 218 }, { 0x01AC, 1, 1, 1 }, { 0x01AE, 1, 1, 218 },
+    { 0x01AF, 1, 1, 1 }, { 0x01B1, 2, 1, 217 }, { 0x01B3, 2, 2, 1 },
+    { 0x01B7, 1, 1, 219 }, { 0x01B8, 1, 1, 1 }, { 0x01BC, 1, 1, 1 },
+    { 0x01C4, 1, 1, 2 }, { 0x01C5, 1, 1, 1 }, { 0x01C7, 1, 1, 2 },
+    { 0x01C8, 1, 1, 1 }, { 0x01CA, 1, 1, 2 }, { 0x01CB, 9, 2, 1 },
+    { 0x01DE, 9, 2, 1 }, { 0x01F1, 1, 1, 2 }, { 0x01F2, 2, 2, 1 },
+    { 0x01F6, 1, 1, -97 }, { 0x01F7, 1, 1, -56 }, { 0x01F8, 20, 2, 1 },
+    { 0x0220, 1, 1, -130 }, { 0x0222, 9, 2, 1 }, { 0x023B, 1, 1, 1 },
+    { 0x023D, 1, 1, -163 }, { 0x0241, 1, 1, 1 }, { 0x0243, 1, 1, -195 },
+    { 0x0244, 1, 1, 69 }, { 0x0245, 1, 1, 71 }, { 0x0246, 5, 2, 1 },
+    { 0x0370, 2, 2, 1 }, { 0x0376, 1, 1, 1 }, { 0x037F, 1, 1, 116 },
+    { 0x0386, 1, 1, 38 }, { 0x0388, 3, 1, 37 }, { 0x038C, 1, 1, 64 },
+    { 0x038E, 2, 1, 63 }, { 0x0391, 17, 1, 32 }, { 0x03A3, 9, 1, 32 },
+    { 0x03CF, 1, 1, 8 }, { 0x03D8, 12, 2, 1 }, { 0x03F4, 1, 1, -60 },
+    { 0x03F7, 1, 1, 1 }, { 0x03F9, 1, 1, -7 }, { 0x03FA, 1, 1, 1 },
+    { 0x03FD, 3, 1, -130 }, { 0x0400, 16, 1, 80 }, { 0x0410, 32, 1, 32 },
+    { 0x0460, 17, 2, 1 }, { 0x048A, 27, 2, 1 }, { 0x04C0, 1, 1, 15 },
+    { 0x04C1, 7, 2, 1 }, { 0x04D0, 48, 2, 1 }, { 0x0531, 38, 1, 48 },
+    { 0x10A0, 38, 1, 7264 }, { 0x10C7, 1, 1, 7264 }, { 0x10CD, 1, 1, 7264 },
+    { 0x13A0, 80, 1, 38864 }, { 0x13F0, 6, 1, 8 }, { 0x1C90, 43, 1, -3008 },
+    { 0x1CBD, 3, 1, -3008 }, { 0x1E00, 75, 2, 1 }, { 0x1E9E, 1, 1, -7615 },
+    { 0x1EA0, 48, 2, 1 }, { 0x1F08, 8, 1, -8 }, { 0x1F18, 6, 1, -8 },
+    { 0x1F28, 8, 1, -8 }, { 0x1F38, 8, 1, -8 }, { 0x1F48, 6, 1, -8 },
+    { 0x1F59, 4, 2, -8 }, { 0x1F68, 8, 1, -8 }, { 0x1F88, 8, 1, -8 },
+    { 0x1F98, 8, 1, -8 }, { 0x1FA8, 8, 1, -8 }, { 0x1FB8, 2, 1, -8 },
+    { 0x1FBA, 2, 1, -74 }, { 0x1FBC, 1, 1, -9 }, { 0x1FC8, 4, 1, -86 },
+    { 0x1FCC, 1, 1, -9 }, { 0x1FD8, 2, 1, -8 }, { 0x1FDA, 2, 1, -100 },
+    { 0x1FE8, 2, 1, -8 }, { 0x1FEA, 2, 1, -112 }, { 0x1FEC, 1, 1, -7 },
+    { 0x1FF8, 2, 1, -128 }, { 0x1FFA, 2, 1, -126 }, { 0x1FFC, 1, 1, -9 },
+    { 0x2126, 1, 1, -7517 }, { 0x212A, 1, 1, -8383 }, { 0x212B, 1, 1, -8262 },
+    { 0x2132, 1, 1, 28 }, { 0x2160, 16, 1, 16 }, { 0x2183, 1, 1, 1 },
+    { 0x24B6, 26, 1, 26 }, { 0x2C00, 48, 1, 48 }, { 0x2C60, 1, 1, 1 },
+    { 0x2C62, 1, 1, -10743 }, { 0x2C63, 1, 1, -3814 }, { 0x2C64, 1, 1, -10727 },
+    { 0x2C67, 3, 2, 1 }, { 0x2C6D, 1, 1, -10780 }, { 0x2C6E, 1, 1, -10749 },
+    { 0x2C6F, 1, 1, -10783 }, { 0x2C70, 1, 1, -10782 }, { 0x2C72, 1, 1, 1 },
+    { 0x2C75, 1, 1, 1 }, { 0x2C7E, 2, 1, -10815 }, { 0x2C80, 50, 2, 1 },
+    { 0x2CEB, 2, 2, 1 }, { 0x2CF2, 1, 1, 1 }, { 0xA640, 23, 2, 1 },
+    { 0xA680, 14, 2, 1 }, { 0xA722, 7, 2, 1 }, { 0xA732, 31, 2, 1 },
+    { 0xA779, 2, 2, 1 }, { 0xA77D, 1, 1, -35332 }, { 0xA77E, 5, 2, 1 },
+    { 0xA78B, 1, 1, 1 }, { 0xA78D, 1, 1, -42280 }, { 0xA790, 2, 2, 1 },
+    { 0xA796, 10, 2, 1 }, { 0xA7AA, 1, 1, -42308 }, { 0xA7AB, 1, 1, -42319 },
+    { 0xA7AC, 1, 1, -42315 }, { 0xA7AD, 1, 1, -42305 }, { 0xA7AE, 1, 1, -42308 },
+    { 0xA7B0, 1, 1, -42258 }, { 0xA7B1, 1, 1, -42282 }, { 0xA7B2, 1, 1, -42261 },
+    { 0xA7B3, 1, 1, 928 }, { 0xA7B4, 8, 2, 1 }, { 0xA7C4, 1, 1, -48 },
+    { 0xA7C5, 1, 1, -42307 }, { 0xA7C6, 1, 1, -35384 }, { 0xA7C7, 2, 2, 1 },
+    { 0xA7D0, 1, 1, 1 }, { 0xA7D6, 2, 2, 1 }, { 0xA7F5, 1, 1, 1 },
+    { 0xFF21, 26, 1, 32 }, { 0x10400, 40, 1, 40 }, { 0x104B0, 36, 1, 40 },
+    { 0x10570, 11, 1, 39 }, { 0x1057C, 15, 1, 39 }, { 0x1058C, 7, 1, 39 },
+    { 0x10594, 2, 1, 39 }, { 0x10C80, 51, 1, 64 }, { 0x118A0, 32, 1, 32 },
+    { 0x16E40, 32, 1, 32 }, { 0x1E900, 34, 1, 34 },
+};
+
+// caseRanges expanded for everything below U+0800 (Latin, Greek, Cyrillic, ...), built at compile time
+inline constexpr std::array<char16_t, 0x800> lowerBelow0800{ [] {
+    std::array<char16_t, 0x800> table{};
+    for (std::size_t cp{ 0 }; cp < table.size(); ++cp)
+        table[cp] = static_cast<char16_t>(cp < 0x80 ? AsciiNamePolicy::toLower(static_cast<unsigned char>(cp)) : cp);
+    for (const CaseRange &range : caseRanges)
+    {
+        for (std::size_t i{ 0 }; i < range.count; ++i)
+        {
+            char32_t cp{ range.first + static_cast<char32_t>(i * range.stride) };
+            if (cp < table.size())
+                table[cp] = static_cast<char16_t>(static_cast<std::int32_t>(cp) + range.delta);
+        }
+    }
+    return table;
+}() };
+
+inline char32_t toLowerCodePoint(char32_t cp)
+{
+    if (cp < lowerBelow0800.size())
+        return lowerBelow0800[cp];
+
+    // the last range starting at or before cp
+    const CaseRange *range{ std::upper_bound(std::begin(caseRanges), std::end(caseRanges), cp,
+                                             [](char32_t value, const CaseRange &r) { return value < r.first; }) };
+    if (range == std::begin(caseRanges))
+        return cp;
+    --range;
+
+    // strides are 1 or 2, so no division is needed
+    char32_t offset{ cp - range->first };
+    if ((range->stride == 2 && (offset & 1)) || offset >= char32_t{ range->count } * range->stride)
+        return cp;
+    return static_cast<char32_t>(static_cast<std::int32_t>(cp) + range->delta);
+}
+
+inline bool isUnicodeSpace(char32_t cp)
+{
+    if (cp < 0x80)
+        return AsciiNameTables::space[cp];
+
+    return cp == 0x85 || cp == 0xA0 || cp == 0x1680 || (cp >= 0x2000 && cp <= 0x200A) ||
+           cp == 0x2028 || cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000;
+}
+
+constexpr char32_t invalidCodePoint{ 0xFFFFFFFF };
+
+/* Decodes the sequence starting at first into cp and returns its length.
+Anything that isn't well-formed UTF-8 (stray continuation bytes, overlong forms,
+surrogates, truncated sequences) decodes as one byte of invalidCodePoint. */
+inline std::size_t decodeUtf8(const unsigned char *first, const unsigned char *last, char32_t &cp)
+{
+    unsigned char lead{ *first };
+    std::size_t length{};
+    char32_t min{};
+    if (lead < 0x80)
+    {
+        cp = lead;
+        return 1;
+    }
+    else if ((lead & 0xE0) == 0xC0)
+    {
+        length = 2;
+        cp = lead & 0x1F;
+        min = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        length = 3;
+        cp = lead & 0x0F;
+        min = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        length = 4;
+        cp = lead & 0x07;
+        min = 0x10000;
+    }
+    else
+    {
+        cp = invalidCodePoint;
+        return 1;
+    }
+
+    if (static_cast<std::size_t>(last - first) < length)
+    {
+        cp = invalidCodePoint;
+        return 1;
+    }
+
+    for (std::size_t i{ 1 }; i < length; ++i)
+    {
+        if ((first[i] & 0xC0) != 0x80)
+        {
+            cp = invalidCodePoint;
+            return 1;
+        }
+        cp = (cp << 6) | (first[i] & 0x3F);
+    }
+
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+    {
+        cp = invalidCodePoint;
+        return 1;
+    }
+    return length;
+}
+
+// writes cp as UTF-8 and returns the number of bytes written
+inline std::size_t encodeUtf8(char32_t cp, char *out)
+{
+    if (cp < 0x80)
+    {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* normalize_name for UTF-8 input: trims Unicode whitespace from both ends,
+lowercases every code point and replaces ' ' with '_'. Same contract as the
+ASCII kernel: out needs room for name.size() chars and may equal name.data(). */
+inline std::size_t normalize_name_utf8(std::string_view name, char *out)
+{
+    const auto *first{ reinterpret_cast<const unsigned char *>(name.data()) };
+    const auto *last{ first + name.size() };
+
+    char32_t cp{};
+    while (first != last)
+    {
+        std::size_t length{ decodeUtf8(first, last, cp) };
+        if (!isUnicodeSpace(cp))
+            break;
+        first += length;
+    }
+
+    char *dest{ out };
+    char *end{ out }; // just past the last char that isn't whitespace
+    while (first != last)
+    {
+        unsigned char ch{ *first };
+        if (ch < 0x80)
+        {
+            *dest++ = static_cast<char>(AsciiNameTables::fold[ch]); // may overwrite *first
+            if (!AsciiNameTables::space[ch])
+                end = dest;
+            ++first;
+            continue;
+        }
+
+        std::size_t length{ decodeUtf8(first, last, cp) };
+        char32_t lower{ cp == invalidCodePoint ? cp : toLowerCodePoint(cp) };
+        if (lower == cp)
+        {
+            for (std::size_t i{ 0 }; i < length; ++i) // dest may trail first in the same buffer
+                *dest++ = static_cast<char>(first[i]);
+        }
+        else
+        {
+            dest += encodeUtf8(lower, dest);
+        }
+
+        if (!isUnicodeSpace(cp))
+            end = dest;
+        first += length;
+    }
+
+    return static_cast<std::size_t>(end - out);
+}
+
+#endif
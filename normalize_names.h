@@ -0,0 +1,120 @@
+#ifndef NORMALIZE_NAMES_H
+#define NORMALIZE_NAMES_H
+
+/* Batch normalization into an arena.
+
+Normalizing a vector of std::string means one heap buffer per long name. Here a
+whole batch is normalized into one contiguous piece of a NameArena and handed
+back as string_views into it. reset() rewinds the arena but keeps its memory,
+so a long-running process stops allocating once the arena has grown to the size
+of its largest batch. */
+
+#include "normalize_name.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <vector>
+
+class NameArena
+{
+public:
+    explicit NameArena(std::size_t blockSize = 1 << 20)
+        : m_blockSize{ blockSize }
+    {
+    }
+
+    NameArena(const NameArena &) = delete;
+    NameArena &operator=(const NameArena &) = delete;
+
+    // size bytes aligned to align, valid until reset()
+    void *allocate(std::size_t size, std::size_t align = 1)
+    {
+        while (m_current < m_blocks.size())
+        {
+            Block &block{ m_blocks[m_current] };
+            std::size_t offset{ (m_used + align - 1) / align * align };
+            if (offset + size <= block.size)
+            {
+                m_used = offset + size;
+                return block.data.get() + offset;
+            }
+            ++m_current; // doesn't fit, move on to the next block
+            m_used = 0;
+        }
+
+        // every block allocated so far is full: grow by at least one blockSize
+        std::size_t blockSize{ std::max(m_blockSize, size + align) };
+        m_blocks.push_back({ std::unique_ptr<char[]>(new char[blockSize]), blockSize });
+        ++m_blockAllocations;
+
+        m_current = m_blocks.size() - 1;
+        m_used = 0;
+        return allocate(size, align);
+    }
+
+    // invalidates every view handed out so far, but keeps the memory for reuse
+    void reset()
+    {
+        m_current = 0;
+        m_used = 0;
+    }
+
+    // drops all memory
+    void release()
+    {
+        m_blocks.clear();
+        reset();
+    }
+
+    std::size_t bytesReserved() const
+    {
+        std::size_t total{ 0 };
+        for (const Block &block : m_blocks)
+            total += block.size;
+        return total;
+    }
+
+    // how many times the arena has gone to the heap
+    std::size_t blockAllocations() const { return m_blockAllocations; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    std::size_t m_blockSize;
+    std::size_t m_current{ 0 }; // block being carved up
+    std::size_t m_used{ 0 };    // bytes used in that block
+    std::size_t m_blockAllocations{ 0 };
+};
+
+/* Normalizes every name into arena and returns their views, in input order. The
+results of one call share a single contiguous buffer; they stay valid until
+arena.reset(). */
+inline std::span<const std::string_view> normalize_names(std::span<const std::string_view> names, NameArena &arena)
+{
+    std::size_t total{ 0 };
+    for (std::string_view name : names)
+        total += name.size();
+
+    auto *views{ static_cast<std::string_view *>(
+        arena.allocate(names.size() * sizeof(std::string_view), alignof(std::string_view))) };
+    char *out{ static_cast<char *>(arena.allocate(total)) };
+
+    for (std::size_t i{ 0 }; i < names.size(); ++i)
+    {
+        std::size_t count{ normalize_name(names[i], out) };
+        new (views + i) std::string_view(out, count);
+        out += count;
+    }
+
+    return { views, names.size() };
+}
+
+#endif
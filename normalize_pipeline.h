@@ -0,0 +1,191 @@
+#ifndef NORMALIZE_PIPELINE_H
+#define NORMALIZE_PIPELINE_H
+
+/* Configurable normalization pipeline.
+
+normalize_name always trims, lowercases and replaces ' ' with '_'. Feeds that
+need something else list the stages they want as template arguments:
+
+    NamePipeline<Trim, Lowercase, CollapseSpace, StripPunct, ReplaceSpace<'-'>>::run(name, out)
+
+Whatever the order of the arguments, the stages apply as strip punctuation,
+trim, collapse whitespace, lowercase, replace separator, so whitespace that
+stripping leaves at either end is trimmed too. Everything that isn't listed
+is removed with if constexpr, and the per-byte work of the selected stages is
+folded into 256-entry tables at compile time, so the whole pipeline is a single
+pass. Like normalize_name, out needs room for name.size() chars and may equal
+name.data(). */
+
+#include "normalize_name_simd.h"
+#include "normalize_name_tables.h"
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// the defaults every stage starts from; a stage switches on the part it owns
+struct NameStage
+{
+    static constexpr bool trim{ false };
+    static constexpr bool lowercase{ false };
+    static constexpr bool collapse{ false };
+    static constexpr bool stripPunct{ false };
+    static constexpr char separator{ '\0' }; // '\0' leaves spaces alone
+};
+
+// removes leading and trailing whitespace, including any that stripping punctuation uncovers
+struct Trim : NameStage
+{
+    static constexpr bool trim{ true };
+};
+
+// 'A'..'Z' become 'a'..'z'
+struct Lowercase : NameStage
+{
+    static constexpr bool lowercase{ true };
+};
+
+// every run of whitespace becomes a single separator (a single ' ' if none is set)
+struct CollapseSpace : NameStage
+{
+    static constexpr bool collapse{ true };
+};
+
+// drops ASCII punctuation such as '.', ',' and '\''
+struct StripPunct : NameStage
+{
+    static constexpr bool stripPunct{ true };
+};
+
+// ' ' becomes Separator
+template <char Separator>
+struct ReplaceSpace : NameStage
+{
+    static constexpr char separator{ Separator };
+};
+
+constexpr bool isAsciiPunct(unsigned char ch)
+{
+    return (ch >= '!' && ch <= '/') || (ch >= ':' && ch <= '@') ||
+           (ch >= '[' && ch <= '`') || (ch >= '{' && ch <= '~');
+}
+
+template <typename... Stages>
+struct NamePipeline
+{
+    static constexpr bool trim{ (Stages::trim || ...) };
+    static constexpr bool lowercase{ (Stages::lowercase || ...) };
+    static constexpr bool collapse{ (Stages::collapse || ...) };
+    static constexpr bool stripPunct{ (Stages::stripPunct || ...) };
+    static constexpr char separator{ [] {
+        char result{ '\0' };
+        ((result = Stages::separator ? Stages::separator : result), ...);
+        return result;
+    }() };
+
+    // what a run of whitespace turns into when collapsing
+    static constexpr char gap{ separator ? separator : ' ' };
+
+    // output byte for every input byte that is kept
+    static constexpr std::array<char, 256> map{ [] {
+        std::array<char, 256> table{};
+        for (std::size_t i{ 0 }; i < table.size(); ++i)
+        {
+            auto ch{ static_cast<unsigned char>(i) };
+            if (lowercase)
+                ch = AsciiNamePolicy::toLower(ch);
+            if (separator && ch == ' ')
+                ch = static_cast<unsigned char>(separator);
+            table[i] = static_cast<char>(ch);
+        }
+        return table;
+    }() };
+
+    static constexpr std::array<bool, 256> punct{ [] {
+        std::array<bool, 256> table{};
+        for (std::size_t i{ 0 }; i < table.size(); ++i)
+            table[i] = isAsciiPunct(static_cast<unsigned char>(i));
+        return table;
+    }() };
+
+    static std::size_t run(std::string_view name, char *out)
+    {
+        const char *first{ name.data() };
+        const char *last{ first + name.size() };
+        if constexpr (trim)
+        {
+            first = skipSpace(first, last);
+            last = skipSpaceBack(first, last);
+        }
+
+        if constexpr (!collapse && !stripPunct && lowercase)
+        {
+            // nothing but a byte-for-byte map is left: the SIMD kernel does exactly that
+            std::size_t count{ static_cast<std::size_t>(last - first) };
+            lowerReplace(first, count, out, ' ', separator ? separator : ' ');
+            return count;
+        }
+        else
+        {
+            // with punctuation stripped, the raw trim above can leave whitespace at either end
+            constexpr bool trimKept{ trim && stripPunct };
+
+            char *dest{ out };
+            [[maybe_unused]] char *end{ out }; // just past the last kept byte that isn't whitespace
+            [[maybe_unused]] bool inGap{ false };
+
+            for (; first != last; ++first)
+            {
+                auto ch{ static_cast<unsigned char>(*first) };
+
+                if constexpr (stripPunct)
+                {
+                    if (punct[ch])
+                        continue;
+                }
+
+                if constexpr (trimKept)
+                {
+                    if (dest == out && AsciiNameTables::space[ch])
+                        continue;
+                }
+
+                if constexpr (collapse)
+                {
+                    if (AsciiNameTables::space[ch])
+                    {
+                        inGap = true;
+                        continue;
+                    }
+                    if (inGap)
+                    {
+                        *dest++ = gap;
+                        inGap = false;
+                    }
+                }
+
+                *dest++ = map[ch];
+                if constexpr (trimKept)
+                {
+                    if (!AsciiNameTables::space[ch])
+                        end = dest;
+                }
+            }
+
+            if constexpr (trimKept)
+                dest = end;
+
+            if constexpr (collapse && !trim)
+            {
+                if (inGap)
+                    *dest++ = gap;
+            }
+
+            return static_cast<std::size_t>(dest - out);
+        }
+    }
+};
+
+// the stages of normalize_name; the output matches normalize_name_ascii byte for byte
+using DefaultNamePipeline = NamePipeline<Trim, Lowercase, ReplaceSpace<'_'>>;
+
+#endif